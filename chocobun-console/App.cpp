@@ -23,9 +23,12 @@
 // include files
 
 #include <App.hpp>
+#include <core/Utils.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <chrono>
 
 // --------------------------------------------------------------
 // constructor
@@ -122,6 +125,8 @@ void App::go( void )
                             delete m_Collection;
                         m_Collection = new Chocobun::Collection();
                         m_Collection->addLevelListener( this );
+                        m_Collection->enableLazyLoading();
+                        m_Collection->setNumParserThreads( 0 );
                         m_Collection->load( fileName );
                         std::cout << "Successfully opened collection \"" << m_Collection->getName() << "\"";
 						std::cout << " from file \"" << fileName << "\"" << std::endl;
@@ -197,6 +202,8 @@ void App::go( void )
                 bool open = false;
                 bool close = false;
                 bool reset = false;
+                bool solve = false;
+                bool deadlocks = false;
                 std::vector<std::string>::iterator it = optionList.begin();
                 for( ; it != optionList.end(); ++it )
                 {
@@ -204,6 +211,8 @@ void App::go( void )
                     if( it->compare("o") == 0 || it->compare("--open") == 0 ){ open=true; continue; }
                     if( it->compare("c") == 0 || it->compare("--close") == 0 ){ close=true; continue; }
                     if( it->compare("r") == 0 || it->compare("--reset") == 0 ){ reset=true; continue; }
+                    if( it->compare("s") == 0 || it->compare("--solve") == 0 ){ solve=true; continue; }
+                    if( it->compare("d") == 0 || it->compare("--deadlocks") == 0 ){ deadlocks=true; continue; }
                     std::cout << "Error: Unkown option \"" << *it << "\"" << std::endl;
                     break;
                 }
@@ -233,10 +242,140 @@ void App::go( void )
                 if( open )
                 {
                     m_Collection->selectActiveLevel( argList.at( argList.size()-1 ) );
+                    if( deadlocks )
+                        m_Collection->getLevel( argList.at( argList.size()-1 ) ).setDeadlockDetection( true );
                     std::cout << "Opened level \"" << argList.at( argList.size()-1 ) << std::endl;
                     m_Collection->streamTileData( std::cout );
                }
 
+                // solve level from its current position
+                if( solve )
+                {
+                    std::string levelName = argList.at( argList.size()-1 );
+                    m_Collection->selectActiveLevel( levelName );
+                    Chocobun::Solver solver;
+                    std::string solution;
+                    switch( solver.solve( m_Collection->getLevel( levelName ), solution ) )
+                    {
+                        case Chocobun::Solver::RESULT_SOLVED :
+                            std::cout << "Solution: " << solution << std::endl; break;
+                        case Chocobun::Solver::RESULT_UNSOLVABLE :
+                            std::cout << "Level \"" << levelName << "\" can't be solved from this position" << std::endl; break;
+                        case Chocobun::Solver::RESULT_TIME_LIMIT :
+                            std::cout << "Error: time limit reached" << std::endl; break;
+                        case Chocobun::Solver::RESULT_MEMORY_LIMIT :
+                            std::cout << "Error: memory limit reached" << std::endl; break;
+                    }
+                    std::cout << solver.getNumExpandedStates() << " states expanded" << std::endl;
+                }
+
+                break;
+            }
+
+            // verify command
+            if( argList[0].compare("verify") == 0 )
+            {
+
+                // verify options
+                bool unsolvedOnly = false;
+                std::vector<std::string>::iterator it = optionList.begin();
+                for( ; it != optionList.end(); ++it )
+                {
+                    if( it->compare("u") == 0 || it->compare("--unsolved") == 0 ){ unsolvedOnly=true; continue; }
+                    std::cout << "Error: Unkown option \"" << *it << "\"" << std::endl;
+                    break;
+                }
+                if( it != optionList.end() ) break;
+
+                // collection must be open
+                if( !m_Collection )
+                {
+                    std::cout << "Error: You haven't opened a collection yet." << std::endl;
+                    break;
+                }
+
+                // optional number of threads
+                Chocobun::SolutionVerifier verifier;
+                if( argList.size() > 1 )
+                {
+                    std::stringstream ss( argList.at( argList.size()-1 ) );
+                    std::size_t numThreads = 0;
+                    if( !(ss >> numThreads) )
+                    {
+                        std::cout << "Error: Invalid number of threads \"" << argList.at( argList.size()-1 ) << "\"" << std::endl;
+                        break;
+                    }
+                    verifier.setNumThreads( numThreads );
+                }
+
+                verifier.verify( *m_Collection );
+                const std::vector<Chocobun::SolutionVerifier::Result>& results = verifier.getResults();
+                for( std::vector<Chocobun::SolutionVerifier::Result>::const_iterator result = results.begin(); result != results.end(); ++result )
+                {
+                    if( unsolvedOnly && result->isSolved ) continue;
+                    std::cout << result->levelName << ": ";
+                    if( !result->isValid )
+                        std::cout << "invalid level";
+                    else if( !result->isLegal )
+                        std::cout << "illegal move after " << result->numMoves << " moves";
+                    else
+                        std::cout << ( result->isSolved ? "solved" : "unsolved" ) << ", " << result->numMoves << " moves, " << result->numPushes << " pushes";
+                    std::cout << std::endl;
+                }
+                std::cout << verifier.getNumSolved() << " of " << results.size() << " levels solved in " << verifier.getElapsedTime() << " seconds (";
+                std::cout << verifier.getLevelsPerSecond() << " levels/sec)" << std::endl;
+                break;
+            }
+
+            // benchmark command
+            if( argList[0].compare("benchmark") == 0 )
+            {
+                if( argList.size() < 2 )
+                {
+                    std::cout << "Error: No collection specified." << std::endl;
+                    break;
+                }
+                std::string fileName = "../../collections/" + argList.at( argList.size()-1 );
+                std::ifstream file( fileName.c_str() );
+                if( !file )
+                {
+                    std::cout << "Error: Collection \"" << fileName << "\" not found." << std::endl;
+                    break;
+                }
+
+                // split the file into lines first, so only classifying them is timed
+                std::vector<std::string> lines;
+                std::size_t numBytes = 0;
+                for( std::string line; std::getline( file, line ); numBytes += line.size() + 1 )
+                    lines.push_back( line );
+
+                // classify all lines for at least a second
+                std::size_t numPasses = 0;
+                std::size_t numTileLines = 0;
+                double elapsed = 0;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                do{
+                    numTileLines = 0;
+                    for( std::vector<std::string>::iterator it = lines.begin(); it != lines.end(); ++it )
+                        if( Chocobun::Utils::isTileData( *it ) ) ++numTileLines;
+                    ++numPasses;
+                    elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+                }while( elapsed < 1.0 );
+                std::cout << "Classified " << lines.size() << " lines (" << numTileLines << " tile data) " << numPasses << " times: ";
+                std::cout << numBytes * numPasses / elapsed / 1048576.0 << " MB/s, SIMD: " << Chocobun::Utils::getInstructionSet() << std::endl;
+
+                // parse the whole collection, and only scan it for levels
+                for( int lazy = 0; lazy != 2; ++lazy )
+                {
+                    start = std::chrono::steady_clock::now();
+                    {
+                        Chocobun::Collection collection;
+                        if( lazy ) collection.enableLazyLoading();
+                        collection.load( fileName );
+                    }
+                    elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+                    std::cout << ( lazy ? "Scanned" : "Parsed" ) << " collection in " << elapsed << " seconds" << std::endl;
+                }
                 break;
             }
 
@@ -394,6 +533,21 @@ bool App::displayHelp( const std::string& cmd )
         std::cout << "     -o, --open         opens the specified level" << std::endl;
         std::cout << "     -c, --close        closes the current level" << std::endl;
         std::cout << "     -r, --reset        resets the level" << std::endl;
+        std::cout << "     -s, --solve        solves the specified level from its current position" << std::endl;
+        std::cout << "     -d, --deadlocks    reports pushes which make the level unsolvable, use with --open" << std::endl;
+        helped = true;
+    }
+    if( cmd.compare("verify") == 0 || cmd.compare("help") == 0 )
+    {
+        std::cout << " verify [OPTIONS] [THREADS]" << std::endl;
+        std::cout << "                        replays the snapshot of every level in the collection" << std::endl;
+        std::cout << "     -u, --unsolved     only lists levels which aren't solved" << std::endl;
+        helped = true;
+    }
+    if( cmd.compare("benchmark") == 0 || cmd.compare("help") == 0 )
+    {
+        std::cout << " benchmark COLLECTION" << std::endl;
+        std::cout << "                        measures how fast the collection is classified and parsed" << std::endl;
         helped = true;
     }
     if( cmd.compare("move") == 0 || cmd.compare("help") == 0 )
@@ -414,3 +568,17 @@ void App::onSetTile( const std::size_t& x, const std::size_t& y, const char& til
 {
     std::cout << "set tile" << std::endl;
 }
+
+void App::onDeadlock( const std::size_t& x, const std::size_t& y, const Chocobun::DeadlockDetector::Type& type )
+{
+    std::cout << "Warning: the box pushed to " << x << "," << y << " can no longer be solved (";
+    switch( type )
+    {
+        case Chocobun::DeadlockDetector::DEADLOCK_DEAD_SQUARE: std::cout << "dead square"; break;
+        case Chocobun::DeadlockDetector::DEADLOCK_FROZEN: std::cout << "frozen boxes"; break;
+        case Chocobun::DeadlockDetector::DEADLOCK_BIPARTITE: std::cout << "not enough reachable goals"; break;
+        case Chocobun::DeadlockDetector::DEADLOCK_CORRAL: std::cout << "closed corral"; break;
+        default: break;
+    }
+    std::cout << "). Type 'z' to undo the push." << std::endl;
+}
@@ -79,6 +79,7 @@ private:
     bool displayHelp( const std::string& cmd );
 
     void onSetTile( const std::size_t& x, const std::size_t& y, const char& tile );
+    void onDeadlock( const std::size_t& x, const std::size_t& y, const Chocobun::DeadlockDetector::Type& type );
 
     Chocobun::Collection* m_Collection;
     std::string m_FileFormat;
@@ -19,7 +19,12 @@
 #define __CHOCOBUN_INTERFACE_HPP__
 
 #include <core/Collection.hpp>
+#include <core/Level.hpp>
 #include <core/LevelListener.hpp>
+#include <core/CollectionParserListener.hpp>
+#include <core/DeadlockDetector.hpp>
 #include <core/Exception.hpp>
+#include <core/Solver.hpp>
+#include <core/SolutionVerifier.hpp>
 
 #endif // __CHOCOBUN_INTERFACE_HPP__
@@ -19,6 +19,9 @@
 // Array2D.hxx
 // --------------------------------------------------------------
 
+#ifndef __CHOCOBUN_CORE_ARRAY2D_HPP__
+#define __CHOCOBUN_CORE_ARRAY2D_HPP__
+
 // --------------------------------------------------------------
 // include files
 
@@ -26,7 +29,8 @@
 #include <core/Exception.hpp>
 
 #include <sstream>
-#include <algorithm> // std::reverse
+#include <algorithm> // std::reverse, std::swap_ranges, std::copy
+#include <utility> // std::move, std::swap
 
 namespace Chocobun {
 
@@ -51,7 +55,7 @@ Array2D<T>::Array2D( const T& content ) :
 // --------------------------------------------------------------
 template <class T>
 Array2D<T>::Array2D( const Array2D& that ) :
-    m_DefaultContent( T() )
+    m_DefaultContent( that.m_DefaultContent )
 {
     *this = that;
 }
@@ -64,6 +68,19 @@ Array2D<T>::Array2D( const Array2D& that, const T& content ) :
     *this = that;
 }
 
+// --------------------------------------------------------------
+template <class T>
+Array2D<T>::Array2D( Array2D&& that ) noexcept :
+    m_DefaultContent( that.m_DefaultContent ),
+    m_SizeX( that.m_SizeX ),
+    m_SizeY( that.m_SizeY ),
+    m_Array( std::move( that.m_Array ) )
+{
+    that.m_Array.clear();
+    that.m_SizeX = 0;
+    that.m_SizeY = 0;
+}
+
 // --------------------------------------------------------------
 template <class T>
 Array2D<T>::~Array2D( void )
@@ -89,27 +106,27 @@ template <class T>
 void Array2D<T>::resize( const std::size_t& x, const std::size_t& y )
 {
 
-    // scale x-dimension up or down
-    if( x != m_SizeX )
+    // rows are stored one after another, so only changing the y-dimension
+    // appends or truncates whole rows at the end of the storage
+    if( x == m_SizeX )
     {
-        m_Array.resize( x );
-        while( x > m_SizeX )
-        {
-            m_Array[m_SizeX].resize( m_SizeY, m_DefaultContent );
-            ++m_SizeX;
-        }
-        m_SizeX = x;
-    }
-
-    // scale y-dimension up or down
-    if( y != m_SizeY )
-    {
-        for( typename std::vector< std::vector<T> >::iterator it = m_Array.begin(); it != m_Array.end(); ++it )
-        {
-            it->resize( y, m_DefaultContent );
-        }
+        m_Array.resize( x*y, m_DefaultContent );
         m_SizeY = y;
+        return;
     }
+
+    // changing the x-dimension changes the stride, so every row has to be
+    // moved to its new location
+    std::vector<T> newArray( x*y, m_DefaultContent );
+    std::size_t copyX = std::min( x, m_SizeX );
+    std::size_t copyY = std::min( y, m_SizeY );
+    for( std::size_t row = 0; row != copyY; ++row )
+        std::copy( m_Array.begin() + row*m_SizeX,
+                   m_Array.begin() + row*m_SizeX + copyX,
+                   newArray.begin() + row*x );
+    m_Array.swap( newArray );
+    m_SizeX = x;
+    m_SizeY = y;
 }
 
 // --------------------------------------------------------------
@@ -117,7 +134,8 @@ template <class T>
 void Array2D<T>::mirrorX( void )
 {
     if( m_SizeX <= 1 ) return;
-    std::reverse( m_Array.begin(), m_Array.end() );
+    for( std::size_t y = 0; y != m_SizeY; ++y )
+        std::reverse( m_Array.begin() + y*m_SizeX, m_Array.begin() + (y+1)*m_SizeX );
 }
 
 // --------------------------------------------------------------
@@ -125,7 +143,10 @@ template <class T>
 void Array2D<T>::mirrorY( void )
 {
     if( !m_SizeX || m_SizeY <= 1 ) return;
-    std::reverse( m_Array[0].begin(), m_Array[0].end() );
+    for( std::size_t top = 0, bottom = m_SizeY-1; top < bottom; ++top, --bottom )
+        std::swap_ranges( m_Array.begin() + top*m_SizeX,
+                          m_Array.begin() + (top+1)*m_SizeX,
+                          m_Array.begin() + bottom*m_SizeX );
 }
 
 // --------------------------------------------------------------
@@ -142,34 +163,81 @@ const std::size_t& Array2D<T>::sizeY( void ) const
     return m_SizeY;
 }
 
+// --------------------------------------------------------------
+template <class T>
+const std::size_t& Array2D<T>::stride( void ) const
+{
+    return m_SizeX;
+}
+
+// --------------------------------------------------------------
+template <class T>
+T* Array2D<T>::row( const std::size_t& y )
+{
+    return &m_Array[y*m_SizeX];
+}
+
+// --------------------------------------------------------------
+template <class T>
+const T* Array2D<T>::row( const std::size_t& y ) const
+{
+    return &m_Array[y*m_SizeX];
+}
+
+// --------------------------------------------------------------
+template <class T>
+T* Array2D<T>::data( void )
+{
+    return m_Array.empty() ? 0 : &m_Array[0];
+}
+
+// --------------------------------------------------------------
+template <class T>
+const T* Array2D<T>::data( void ) const
+{
+    return m_Array.empty() ? 0 : &m_Array[0];
+}
+
 // --------------------------------------------------------------
 template <class T>
 Array2D<T>& Array2D<T>::operator=( const Array2D<T>& that )
 {
+    if( this == &that ) return *this;
     m_Array = that.m_Array;
     m_SizeX = that.m_SizeX;
     m_SizeY = that.m_SizeY;
+    return *this;
 }
 
 // --------------------------------------------------------------
 template <class T>
-std::vector<T>& Array2D<T>::operator[]( const std::size_t& index )
+Array2D<T>& Array2D<T>::operator=( Array2D<T>&& that ) noexcept
 {
-    return m_Array[index];
+    if( this == &that ) return *this;
+    m_Array = std::move( that.m_Array );
+    m_SizeX = that.m_SizeX;
+    m_SizeY = that.m_SizeY;
+    that.m_Array.clear();
+    that.m_SizeX = 0;
+    that.m_SizeY = 0;
+    return *this;
 }
 
 // --------------------------------------------------------------
 template <class T>
-const std::vector<T>& Array2D<T>::operator[]( const std::size_t& index ) const
+void Array2D<T>::swap( Array2D<T>& that ) noexcept
 {
-    return m_Array[index];
+    std::swap( m_DefaultContent, that.m_DefaultContent );
+    std::swap( m_SizeX, that.m_SizeX );
+    std::swap( m_SizeY, that.m_SizeY );
+    m_Array.swap( that.m_Array );
 }
 
 // --------------------------------------------------------------
 template <class T>
 const T& Array2D<T>::at( const std::size_t& x, const std::size_t& y ) const
 {
-    return m_Array[x][y];
+    return m_Array[y*m_SizeX+x];
 }
 
 // --------------------------------------------------------------
@@ -181,7 +249,9 @@ T& Array2D<T>::at( const std::size_t& x, const std::size_t& y )
         std::stringstream ss; ss << "[Array2D::at] Error: coordinates out of bounds: " << x << "," << y;
         throw Exception( ss.str() );
     }
-    return m_Array[x][y];
+    return m_Array[y*m_SizeX+x];
 }
 
 } // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_ARRAY2D_HPP__
@@ -19,6 +19,9 @@
 // Array2D.hpp
 // --------------------------------------------------------------
 
+#ifndef __CHOCOBUN_CORE_ARRAY2D_HXX__
+#define __CHOCOBUN_CORE_ARRAY2D_HXX__
+
 // --------------------------------------------------------------
 // include files
 
@@ -28,7 +31,11 @@
 namespace Chocobun {
 
 /*!
- * @brief Wraps a dynamic 2-dimensional array with std::vector< std::vector<T> > at its core
+ * @brief Wraps a dynamic 2-dimensional array with a single contiguous std::vector<T> at its core
+ *
+ * Elements are stored row-major, i.e. the element at (x,y) is found at
+ * index y*stride()+x. Copying an array is therefore a single block copy,
+ * and all elements of a row share the same cache lines.
  */
 template <class T>
 class Array2D
@@ -58,6 +65,12 @@ public:
      */
     Array2D( const Array2D& that, const T& content );
 
+    /*!
+     * @brief Move Constructor
+     * Takes over the elements of the other array, which is left empty.
+     */
+    Array2D( Array2D&& that ) noexcept;
+
     /*!
      * @brief Default destructor
      */
@@ -105,6 +118,40 @@ public:
      */
     const std::size_t& sizeY( void ) const;
 
+    /*!
+     * @brief Gets the distance in elements between two vertically adjacent elements
+     * @note This is always equal to @a sizeX
+     */
+    const std::size_t& stride( void ) const;
+
+    /*!
+     * @brief Gets a pointer to the first element of a row
+     * The row is contiguous in memory and holds @a sizeX elements.
+     * @note No boundary checking is performed
+     * @param y The y-coordinate of the row
+     */
+    T* row( const std::size_t& y );
+
+    /*!
+     * @brief Gets a constant pointer to the first element of a row
+     * The row is contiguous in memory and holds @a sizeX elements.
+     * @note No boundary checking is performed
+     * @param y The y-coordinate of the row
+     */
+    const T* row( const std::size_t& y ) const;
+
+    /*!
+     * @brief Gets a pointer to the underlying contiguous storage
+     * @return A pointer to the element at (0,0), or 0 if the array is empty
+     */
+    T* data( void );
+
+    /*!
+     * @brief Gets a constant pointer to the underlying contiguous storage
+     * @return A pointer to the element at (0,0), or 0 if the array is empty
+     */
+    const T* data( void ) const;
+
     /*!
      * @brief Gets a character from the array at the specified coordinates
      * Enables the use of reading from the Array2D with boundary checking
@@ -125,27 +172,29 @@ public:
 
     /*!
      * @brief Overload assignment operator
+     * If both arrays have the same dimensions, no memory is allocated.
      */
     Array2D<T>& operator=( const Array2D<T>& that );
 
     /*!
-     * @brief Subscript operator overload
-     * Enables the use of writing to the Array2D using [][]
+     * @brief Overload move assignment operator
+     * Takes over the elements of the other array, which is left empty.
      */
-    std::vector<T>& operator[]( const std::size_t& index );
+    Array2D<T>& operator=( Array2D<T>&& that ) noexcept;
 
     /*!
-     * @brief Subscript operator overload
-     * Enables the use of reading from the Array2D using [][]
+     * @brief Exchanges the contents of two arrays without copying them
      */
-    const std::vector<T>& operator[]( const std::size_t& index ) const;
+    void swap( Array2D<T>& that ) noexcept;
 
 private:
 
     T                               m_DefaultContent;
     std::size_t                     m_SizeX;
     std::size_t                     m_SizeY;
-    std::vector< std::vector<T> >   m_Array; // NOTE: outer vector: x-dimension, inner vector: y-dimension
+    std::vector<T>                  m_Array; // NOTE: row-major, index is y*m_SizeX+x
 };
 
 } // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_ARRAY2D_HXX__
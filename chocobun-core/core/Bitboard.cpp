@@ -0,0 +1,345 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// Bitboard.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Bitboard.hpp>
+
+#include <utility> // std::swap
+
+namespace Chocobun {
+
+const std::size_t Bitboard::npos = static_cast<std::size_t>(-1);
+
+// --------------------------------------------------------------
+// helpers
+
+namespace {
+
+// --------------------------------------------------------------
+std::size_t countBits( Uint64 word )
+{
+#if defined(__GNUC__)
+    return static_cast<std::size_t>( __builtin_popcountll( word ) );
+#else
+    std::size_t count = 0;
+    for( ; word; word &= word-1 ) ++count;
+    return count;
+#endif
+}
+
+// --------------------------------------------------------------
+// expects word to be non-zero
+std::size_t lowestBit( Uint64 word )
+{
+#if defined(__GNUC__)
+    return static_cast<std::size_t>( __builtin_ctzll( word ) );
+#else
+    std::size_t bit = 0;
+    while( !(word & 1) ){ word >>= 1; ++bit; }
+    return bit;
+#endif
+}
+
+// --------------------------------------------------------------
+// returns word i of the bit vector shifted towards higher indices
+Uint64 shiftedUp( const std::vector<Uint64>& words, const std::size_t& i, const std::size_t& shift )
+{
+    std::size_t wordShift = shift >> 6, bitShift = shift & 63;
+    if( i < wordShift ) return 0;
+    Uint64 result = words[i-wordShift] << bitShift;
+    if( bitShift && i > wordShift )
+        result |= words[i-wordShift-1] >> (64-bitShift);
+    return result;
+}
+
+// --------------------------------------------------------------
+// returns word i of the bit vector shifted towards lower indices
+Uint64 shiftedDown( const std::vector<Uint64>& words, const std::size_t& i, const std::size_t& shift )
+{
+    std::size_t wordShift = shift >> 6, bitShift = shift & 63;
+    if( i+wordShift >= words.size() ) return 0;
+    Uint64 result = words[i+wordShift] >> bitShift;
+    if( bitShift && i+wordShift+1 < words.size() )
+        result |= words[i+wordShift+1] << (64-bitShift);
+    return result;
+}
+
+} // anonymous namespace
+
+// --------------------------------------------------------------
+Bitboard::Bitboard( void ) :
+    m_SizeX( 0 ),
+    m_SizeY( 0 ),
+    m_Stride( 0 ),
+    m_Size( 0 )
+{
+}
+
+// --------------------------------------------------------------
+Bitboard::Bitboard( const std::size_t& sizeX, const std::size_t& sizeY ) :
+    m_SizeX( 0 ),
+    m_SizeY( 0 ),
+    m_Stride( 0 ),
+    m_Size( 0 )
+{
+    this->resize( sizeX, sizeY );
+}
+
+// --------------------------------------------------------------
+Bitboard::~Bitboard( void )
+{
+}
+
+// --------------------------------------------------------------
+void Bitboard::swap( Bitboard& that ) noexcept
+{
+    m_Words.swap( that.m_Words );
+    std::swap( m_SizeX, that.m_SizeX );
+    std::swap( m_SizeY, that.m_SizeY );
+    std::swap( m_Stride, that.m_Stride );
+    std::swap( m_Size, that.m_Size );
+}
+
+// --------------------------------------------------------------
+void Bitboard::resize( const std::size_t& sizeX, const std::size_t& sizeY )
+{
+    m_SizeX = sizeX;
+    m_SizeY = sizeY;
+    m_Stride = sizeX + 2;
+    m_Size = m_Stride * (sizeY + 2);
+    m_Words.assign( (m_Size + 63) >> 6, 0 );
+}
+
+// --------------------------------------------------------------
+void Bitboard::clear( void )
+{
+    m_Words.assign( m_Words.size(), 0 );
+}
+
+// --------------------------------------------------------------
+void Bitboard::setBorder( void )
+{
+    if( !m_Size ) return;
+    for( std::size_t x = 0; x != m_Stride; ++x )
+    {
+        this->set( x );
+        this->set( m_Size - m_Stride + x );
+    }
+    for( std::size_t y = 1; y <= m_SizeY; ++y )
+    {
+        this->set( y*m_Stride );
+        this->set( y*m_Stride + m_Stride - 1 );
+    }
+}
+
+// --------------------------------------------------------------
+void Bitboard::invert( void )
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        m_Words[i] = ~m_Words[i];
+
+    // bits past the end of the board must remain cleared
+    if( m_Size & 63 )
+        m_Words.back() &= ( Uint64(1) << (m_Size & 63) ) - 1;
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::index( const std::size_t& x, const std::size_t& y ) const
+{
+    return (y+1)*m_Stride + (x+1);
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::indexToX( const std::size_t& index ) const
+{
+    return index % m_Stride - 1;
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::indexToY( const std::size_t& index ) const
+{
+    return index / m_Stride - 1;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Bitboard::sizeX( void ) const
+{
+    return m_SizeX;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Bitboard::sizeY( void ) const
+{
+    return m_SizeY;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Bitboard::stride( void ) const
+{
+    return m_Stride;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Bitboard::size( void ) const
+{
+    return m_Size;
+}
+
+// --------------------------------------------------------------
+bool Bitboard::test( const std::size_t& index ) const
+{
+    if( index >= m_Size ) return false;
+    return ( (m_Words[index >> 6] >> (index & 63)) & 1 ) != 0;
+}
+
+// --------------------------------------------------------------
+void Bitboard::set( const std::size_t& index )
+{
+    m_Words[index >> 6] |= Uint64(1) << (index & 63);
+}
+
+// --------------------------------------------------------------
+void Bitboard::reset( const std::size_t& index )
+{
+    m_Words[index >> 6] &= ~(Uint64(1) << (index & 63));
+}
+
+// --------------------------------------------------------------
+bool Bitboard::any( void ) const
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        if( m_Words[i] ) return true;
+    return false;
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::count( void ) const
+{
+    std::size_t total = 0;
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        total += countBits( m_Words[i] );
+    return total;
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::findFirst( void ) const
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        if( m_Words[i] )
+            return (i << 6) + lowestBit( m_Words[i] );
+    return npos;
+}
+
+// --------------------------------------------------------------
+std::size_t Bitboard::findNext( const std::size_t& index ) const
+{
+    std::size_t next = index + 1;
+    if( next >= m_Size ) return npos;
+
+    // remaining bits of the current word
+    std::size_t i = next >> 6;
+    Uint64 word = m_Words[i] & ( ~Uint64(0) << (next & 63) );
+    if( word ) return (i << 6) + lowestBit( word );
+
+    // following words
+    for( ++i; i < m_Words.size(); ++i )
+        if( m_Words[i] )
+            return (i << 6) + lowestBit( m_Words[i] );
+    return npos;
+}
+
+// --------------------------------------------------------------
+bool Bitboard::isSubsetOf( const Bitboard& that ) const
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        if( m_Words[i] & ~that.m_Words[i] ) return false;
+    return true;
+}
+
+// --------------------------------------------------------------
+bool Bitboard::intersects( const Bitboard& that ) const
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        if( m_Words[i] & that.m_Words[i] ) return true;
+    return false;
+}
+
+// --------------------------------------------------------------
+void Bitboard::andNot( const Bitboard& that )
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        m_Words[i] &= ~that.m_Words[i];
+}
+
+// --------------------------------------------------------------
+void Bitboard::floodFill( const Bitboard& passable )
+{
+    std::vector<Uint64> grown( m_Words.size() );
+    bool changed = true;
+    while( changed )
+    {
+        changed = false;
+        for( std::size_t i = 0; i != m_Words.size(); ++i )
+        {
+            Uint64 word = m_Words[i] |
+                          shiftedUp( m_Words, i, 1 ) |
+                          shiftedDown( m_Words, i, 1 ) |
+                          shiftedUp( m_Words, i, m_Stride ) |
+                          shiftedDown( m_Words, i, m_Stride );
+            word &= passable.m_Words[i] | m_Words[i];
+            if( word != m_Words[i] ) changed = true;
+            grown[i] = word;
+        }
+        m_Words.swap( grown );
+    }
+}
+
+// --------------------------------------------------------------
+Bitboard& Bitboard::operator&=( const Bitboard& that )
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        m_Words[i] &= that.m_Words[i];
+    return *this;
+}
+
+// --------------------------------------------------------------
+Bitboard& Bitboard::operator|=( const Bitboard& that )
+{
+    for( std::size_t i = 0; i != m_Words.size(); ++i )
+        m_Words[i] |= that.m_Words[i];
+    return *this;
+}
+
+// --------------------------------------------------------------
+bool Bitboard::operator==( const Bitboard& that ) const
+{
+    return m_Words == that.m_Words;
+}
+
+// --------------------------------------------------------------
+bool Bitboard::operator!=( const Bitboard& that ) const
+{
+    return m_Words != that.m_Words;
+}
+
+} // namespace Chocobun
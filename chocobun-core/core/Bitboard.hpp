@@ -0,0 +1,241 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// Bitboard.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_BITBOARD_HPP__
+#define __CHOCOBUN_CORE_BITBOARD_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <vector>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief A set of squares on a level, stored as one bit per square
+ *
+ * The board is surrounded by a one square wide padding border, so each row
+ * is sizeX+2 bits long. Because of this, the neighbours of any square on the
+ * board can be reached by adding or subtracting 1 or the stride from its
+ * index without ever wrapping around to the opposite edge of the board.
+ *
+ * All set operations (intersection, union, subset tests, flood fills) work
+ * on 64 squares at a time.
+ */
+class Bitboard
+{
+public:
+
+    /*!
+     * @brief Returned by @a findFirst and @a findNext when no more bits are set
+     */
+    static const std::size_t npos;
+
+    /*!
+     * @brief Default constructor
+     * Constructs an empty board with no squares
+     */
+    Bitboard( void );
+
+    /*!
+     * @brief Constructs a cleared board of the specified dimensions
+     * @param sizeX The width of the board, excluding padding
+     * @param sizeY The height of the board, excluding padding
+     */
+    Bitboard( const std::size_t& sizeX, const std::size_t& sizeY );
+
+    /*!
+     * @brief Destructor
+     */
+    ~Bitboard( void );
+
+    /*!
+     * @brief Exchanges the contents of two boards without copying them
+     */
+    void swap( Bitboard& that ) noexcept;
+
+    /*!
+     * @brief Resizes the board to the specified dimensions
+     * @note All bits are cleared
+     * @param sizeX The width of the board, excluding padding
+     * @param sizeY The height of the board, excluding padding
+     */
+    void resize( const std::size_t& sizeX, const std::size_t& sizeY );
+
+    /*!
+     * @brief Clears all bits, including the padding border
+     */
+    void clear( void );
+
+    /*!
+     * @brief Sets all bits of the padding border surrounding the board
+     */
+    void setBorder( void );
+
+    /*!
+     * @brief Flips every bit, including the padding border
+     */
+    void invert( void );
+
+    /*!
+     * @brief Converts board coordinates to a bit index
+     * The coordinates may be one square outside of the board, in which case
+     * the index of the padding square is returned. Because unsigned arithmetic
+     * is used, this includes x or y being equal to std::size_t(-1).
+     * @param x The x-coordinate of the square
+     * @param y The y-coordinate of the square
+     * @return The bit index of the square
+     */
+    std::size_t index( const std::size_t& x, const std::size_t& y ) const;
+
+    /*!
+     * @brief Converts a bit index back to a x-coordinate on the board
+     */
+    std::size_t indexToX( const std::size_t& index ) const;
+
+    /*!
+     * @brief Converts a bit index back to a y-coordinate on the board
+     */
+    std::size_t indexToY( const std::size_t& index ) const;
+
+    /*!
+     * @brief Gets the width of the board, excluding padding
+     */
+    const std::size_t& sizeX( void ) const;
+
+    /*!
+     * @brief Gets the height of the board, excluding padding
+     */
+    const std::size_t& sizeY( void ) const;
+
+    /*!
+     * @brief Gets the distance in bits between two vertically adjacent squares
+     */
+    const std::size_t& stride( void ) const;
+
+    /*!
+     * @brief Gets the total number of bits, including padding
+     */
+    const std::size_t& size( void ) const;
+
+    /*!
+     * @brief Tests if a bit is set
+     * @return Returns false if the index is out of range
+     */
+    bool test( const std::size_t& index ) const;
+
+    /*!
+     * @brief Sets a bit
+     */
+    void set( const std::size_t& index );
+
+    /*!
+     * @brief Clears a bit
+     */
+    void reset( const std::size_t& index );
+
+    /*!
+     * @brief Checks if any bit is set
+     */
+    bool any( void ) const;
+
+    /*!
+     * @brief Counts the number of set bits
+     */
+    std::size_t count( void ) const;
+
+    /*!
+     * @brief Gets the index of the first set bit
+     * @return The index of the first set bit, or npos if no bits are set
+     */
+    std::size_t findFirst( void ) const;
+
+    /*!
+     * @brief Gets the index of the next set bit after the specified index
+     * @return The index of the next set bit, or npos if no more bits are set
+     */
+    std::size_t findNext( const std::size_t& index ) const;
+
+    /*!
+     * @brief Checks if every set bit is also set in another board
+     * @note Both boards must have the same dimensions
+     */
+    bool isSubsetOf( const Bitboard& that ) const;
+
+    /*!
+     * @brief Checks if any bit is set in both boards
+     * @note Both boards must have the same dimensions
+     */
+    bool intersects( const Bitboard& that ) const;
+
+    /*!
+     * @brief Clears all bits which are set in another board
+     * @note Both boards must have the same dimensions
+     */
+    void andNot( const Bitboard& that );
+
+    /*!
+     * @brief Grows the set bits into all connected squares of a mask
+     *
+     * Repeatedly adds the four neighbours of every set bit, restricted to the
+     * bits set in passable, until nothing changes. If a single bit is set
+     * before calling this, the result is the area reachable from that square.
+     *
+     * @note Both boards must have the same dimensions
+     * @param passable The squares that may be grown into
+     */
+    void floodFill( const Bitboard& passable );
+
+    /*!
+     * @brief Intersection of two boards
+     */
+    Bitboard& operator&=( const Bitboard& that );
+
+    /*!
+     * @brief Union of two boards
+     */
+    Bitboard& operator|=( const Bitboard& that );
+
+    /*!
+     * @brief Compares two boards for equality
+     */
+    bool operator==( const Bitboard& that ) const;
+
+    /*!
+     * @brief Compares two boards for inequality
+     */
+    bool operator!=( const Bitboard& that ) const;
+
+private:
+
+    std::vector<Uint64> m_Words;
+    std::size_t         m_SizeX;
+    std::size_t         m_SizeY;
+    std::size_t         m_Stride;
+    std::size_t         m_Size;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_BITBOARD_HPP__
@@ -26,27 +26,53 @@
 #include <core/CollectionParser.hpp>
 #include <core/Exception.hpp>
 #include <core/Level.hpp>
+#include <core/MappedFile.hpp>
+#include <core/ObjectPool.hpp>
 
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <utility> // std::swap
 
 namespace Chocobun {
 
+const std::size_t Collection::NO_LEVEL = static_cast<std::size_t>(-1);
+
 // --------------------------------------------------------------
 Collection::Collection( void ) :
+    m_ActiveLevel( NO_LEVEL ),
+    m_NumParserThreads( 1 ),
+    m_NextLevelNumber( 1 ),
     m_EnableCompression( false ),
-    m_IsLoaded( false ),
-    m_ActiveLevel( -1 )
+    m_EnableLazyLoading( false ),
+    m_IsLoaded( false )
 {
 }
 
 // --------------------------------------------------------------
 Collection::Collection( const Collection& that ) :
-    m_ActiveLevel( -1 )
+    m_ActiveLevel( NO_LEVEL ),
+    m_NumParserThreads( 1 ),
+    m_NextLevelNumber( 1 )
 {
     *this = that;
 }
 
+// --------------------------------------------------------------
+Collection::Collection( Collection&& that ) noexcept :
+    m_ActiveLevel( NO_LEVEL ),
+    m_NumParserThreads( 1 ),
+    m_NextLevelNumber( 1 ),
+    m_EnableCompression( false ),
+    m_EnableLazyLoading( false ),
+    m_IsLoaded( false )
+{
+    this->swap( that );
+}
+
 // --------------------------------------------------------------
 Collection::~Collection( void )
 {
@@ -72,6 +98,8 @@ void Collection::load( const std::string& fileName )
     m_FileName = fileName;
     CollectionParser cp;
     cp.parse( m_FileName, *this );
+    if( !m_EnableLazyLoading )
+        this->parseAllLevels();
 
     m_IsLoaded = true;
 }
@@ -91,11 +119,16 @@ void Collection::unload( void )
         return;
     }
 
-    // destroy levels
+    // destroy levels and release their memory
     for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
-        delete *it;
+        m_LevelPool.destroy( *it );
+    m_LevelPool.clear();
     m_Levels.clear();
-    m_ActiveLevel = -1;
+    m_LevelIndex.clear();
+    m_LevelSources.clear();
+    m_SourceFile.reset();
+    m_ActiveLevel = NO_LEVEL;
+    m_NextLevelNumber = 1;
 
     m_IsLoaded = false;
 }
@@ -103,6 +136,7 @@ void Collection::unload( void )
 // --------------------------------------------------------------
 void Collection::save( const std::string& fileFormat )
 {
+    this->parseAllLevels();
     CollectionParser cp;
     cp.setFileFormat( fileFormat );
     cp.save( m_FileName, *this, m_EnableCompression );
@@ -138,31 +172,149 @@ bool Collection::isCompressionEnabled( void ) const
     return m_EnableCompression;
 }
 
+// --------------------------------------------------------------
+void Collection::enableLazyLoading( void )
+{
+    m_EnableLazyLoading = true;
+}
+
+// --------------------------------------------------------------
+void Collection::disableLazyLoading( void )
+{
+    m_EnableLazyLoading = false;
+}
+
+// --------------------------------------------------------------
+bool Collection::isLazyLoadingEnabled( void ) const
+{
+    return m_EnableLazyLoading;
+}
+
+// --------------------------------------------------------------
+void Collection::setNumParserThreads( const std::size_t& numThreads )
+{
+    m_NumParserThreads = numThreads;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Collection::getNumParserThreads( void ) const
+{
+    return m_NumParserThreads;
+}
+
+// --------------------------------------------------------------
+void Collection::deferLevel( Level* lvl, const LevelSource& source )
+{
+    m_LevelSources[lvl] = source;
+}
+
+// --------------------------------------------------------------
+void Collection::setSourceFile( const std::shared_ptr<MappedFile>& file )
+{
+    if( m_LevelSources.empty() )
+        m_SourceFile.reset();
+    else
+        m_SourceFile = file;
+}
+
+// --------------------------------------------------------------
+void Collection::parseLevel( Level* lvl )
+{
+    std::map<const Level*, LevelSource>::iterator it = m_LevelSources.find( lvl );
+    if( it == m_LevelSources.end() )
+        return;
+
+    // the source is forgotten even if parsing fails, so a broken level
+    // isn't parsed again on every access
+    LevelSource source = it->second;
+    m_LevelSources.erase( it );
+    std::shared_ptr<MappedFile> file = m_SourceFile;
+    if( m_LevelSources.empty() )
+        m_SourceFile.reset();
+
+    CollectionParser cp;
+    cp.parseLevel( *file, source, *lvl );
+}
+
+// --------------------------------------------------------------
+void Collection::parseAllLevels( void ) const
+{
+    if( m_LevelSources.empty() )
+        return;
+
+    // collect the deferred levels in file order, the workers only read this
+    std::vector<Level*> levels;
+    std::vector<LevelSource> sources;
+    levels.reserve( m_LevelSources.size() );
+    sources.reserve( m_LevelSources.size() );
+    for( std::vector<Level*>::const_iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
+    {
+        std::map<const Level*, LevelSource>::iterator source = m_LevelSources.find( *it );
+        if( source == m_LevelSources.end() )
+            continue;
+        levels.push_back( *it );
+        sources.push_back( source->second );
+    }
+    m_LevelSources.clear();
+    std::shared_ptr<MappedFile> file = m_SourceFile;
+    m_SourceFile.reset();
+
+    // each worker takes the next level until there are none left. Parsing
+    // doesn't notify listeners, so levels can be filled concurrently
+    std::atomic<std::size_t> nextLevel( 0 );
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]()
+    {
+        CollectionParser cp;
+        for( std::size_t i = nextLevel.fetch_add(1); i < levels.size(); i = nextLevel.fetch_add(1) )
+        {
+            try
+            {
+                cp.parseLevel( *file, sources[i], *levels[i] );
+            }
+            catch( ... )
+            {
+                std::lock_guard<std::mutex> lock( errorMutex );
+                if( !error ) error = std::current_exception();
+            }
+        }
+    };
+
+    std::size_t numThreads = m_NumParserThreads;
+    if( !numThreads ) numThreads = std::thread::hardware_concurrency();
+    if( !numThreads ) numThreads = 1;
+    if( numThreads > levels.size() ) numThreads = levels.size();
+    std::vector<std::thread> threads;
+    for( std::size_t i = 1; i < numThreads; ++i )
+        threads.push_back( std::thread( worker ) );
+    worker();
+    for( std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it )
+        it->join();
+
+    // report the first level that failed to parse
+    if( error )
+        std::rethrow_exception( error );
+}
+
 // --------------------------------------------------------------
 Level* Collection::addLevel( void )
 {
-    Level* lvl = new Level();
+    Level* lvl = m_LevelPool.construct();
     m_Levels.push_back( lvl );
     lvl->addListener( this );
+    this->indexLevel( m_Levels.size()-1 );
     return lvl;
 }
 
 // --------------------------------------------------------------
 void Collection::removeLevel( Level* lvl )
 {
-    for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
+    for( std::size_t i = 0; i != m_Levels.size(); ++i )
     {
-        if( *it == lvl )
+        if( m_Levels[i] == lvl )
         {
-
-            // reset active level if it is being removed
-            if( m_Levels[m_ActiveLevel] == *it )
-                m_ActiveLevel = -1;
-
-            // remove level
-            delete *it;
-            it = m_Levels.erase( it );
-
+            this->destroyLevel( i );
             return;
         }
     }
@@ -172,57 +324,98 @@ void Collection::removeLevel( Level* lvl )
 // --------------------------------------------------------------
 void Collection::removeLevel( const std::string& levelName )
 {
-    for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
-    {
-        if( (*it)->getLevelName() == levelName )
-        {
+    std::size_t slot = this->findLevel( levelName );
+    if( slot == NO_LEVEL )
+        throw Exception( "[Collection::removeLevel] Error: Level not registered to this collection: " + levelName );
+    this->destroyLevel( slot );
+}
 
-            // reset active level if it is being removed
-            if( m_Levels[m_ActiveLevel] == *it )
-                m_ActiveLevel = -1;
+// --------------------------------------------------------------
+void Collection::destroyLevel( const std::size_t& slot )
+{
 
-            // remove level
-            delete *it;
-            it = m_Levels.erase( it );
+    // reset active level if it is being removed, and keep pointing at the
+    // same level otherwise
+    if( m_ActiveLevel == slot )
+        m_ActiveLevel = NO_LEVEL;
+    else if( m_ActiveLevel != NO_LEVEL && m_ActiveLevel > slot )
+        --m_ActiveLevel;
 
-            return;
-        }
-    }
-    throw Exception( "[Collection::removeLevel] Error: Level not registered to this collection: " + levelName );
+    // remove level
+    m_LevelSources.erase( m_Levels[slot] );
+    m_LevelPool.destroy( m_Levels[slot] );
+    m_Levels.erase( m_Levels.begin() + slot );
+
+    // all following levels moved
+    this->rebuildLevelIndex();
 }
 
 // --------------------------------------------------------------
 void Collection::generateLevelName( std::string& name )
 {
+    if( name.size() != 0 )
+        return;
+
+    // numbers below the counter are known to be taken, so each name is
+    // only checked once while loading
     std::stringstream ss;
-    std::vector<Level*>::iterator it;
-    if( name.size() == 0 )
-    {
-        Uint32 i = 1;
-        do{
-            ss.clear();
-            ss.str("");
-            ss << "Level #";
-            ss << i;
-            ++i;
-            for( it = m_Levels.begin(); it != m_Levels.end(); ++it )
-                if( (*it)->getLevelName().compare(ss.str()) == 0 )
-                    break;
-        }while( it != m_Levels.end() );
-        name = ss.str();
-        std::cout << "generated level name " << name << std::endl;
-    }
+    do{
+        ss.str("");
+        ss << "Level #" << m_NextLevelNumber;
+        ++m_NextLevelNumber;
+    }while( m_LevelIndex.find( ss.str() ) != m_LevelIndex.end() );
+    name = ss.str();
+
+#ifdef _DEBUG
+    std::cout << "generated level name " << name << std::endl;
+#endif
 }
 
 // --------------------------------------------------------------
 Level* Collection::getLevelPtr( const std::string& levelName )
 {
-    for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
+    std::size_t slot = this->findLevel( levelName );
+    if( slot == NO_LEVEL )
+        throw Exception( "[Collection::getLevelPtr] Error: Level not registered to this collection: " + levelName );
+    this->parseLevel( m_Levels[slot] );
+    return m_Levels[slot];
+}
+
+// --------------------------------------------------------------
+std::size_t Collection::findLevel( const std::string& levelName ) const
+{
+    std::unordered_map<std::string, LevelSlot>::const_iterator it = m_LevelIndex.find( levelName );
+    if( it == m_LevelIndex.end() )
+        return NO_LEVEL;
+    return it->second.index;
+}
+
+// --------------------------------------------------------------
+void Collection::indexLevel( const std::size_t& slot )
+{
+    std::unordered_map<std::string, LevelSlot>::iterator it = m_LevelIndex.find( m_Levels[slot]->getLevelName() );
+    if( it == m_LevelIndex.end() )
     {
-        if( (*it)->getLevelName() == levelName )
-            return *it;
+        LevelSlot entry;
+        entry.index = slot;
+        entry.count = 1;
+        m_LevelIndex[m_Levels[slot]->getLevelName()] = entry;
+        return;
     }
-    throw Exception( "[Collection::getLevelPtr] Error: Level not registered to this collection: " + levelName );
+    ++it->second.count;
+    if( slot < it->second.index )
+        it->second.index = slot;
+}
+
+// --------------------------------------------------------------
+void Collection::rebuildLevelIndex( void )
+{
+    m_LevelIndex.clear();
+    for( std::size_t i = 0; i != m_Levels.size(); ++i )
+        this->indexLevel( i );
+
+    // generated names may have been freed
+    m_NextLevelNumber = 1;
 }
 
 // --------------------------------------------------------------
@@ -275,7 +468,7 @@ void Collection::selectLastLevel( void )
 // --------------------------------------------------------------
 bool Collection::selectNextLevel( void )
 {
-    if( m_ActiveLevel == -1 || m_ActiveLevel+1 == m_Levels.size() ) return false;
+    if( m_ActiveLevel == NO_LEVEL || m_ActiveLevel+1 == m_Levels.size() ) return false;
     ++m_ActiveLevel;
     this->selectActiveLevel( m_Levels[m_ActiveLevel]->getLevelName() );
     return true;
@@ -284,7 +477,7 @@ bool Collection::selectNextLevel( void )
 // --------------------------------------------------------------
 bool Collection::selectPreviousLevel( void )
 {
-    if( m_ActiveLevel == -1 || m_ActiveLevel-1 == 0 ) return false;
+    if( m_ActiveLevel == NO_LEVEL || m_ActiveLevel-1 == 0 ) return false;
     --m_ActiveLevel;
     this->selectActiveLevel( m_Levels[m_ActiveLevel]->getLevelName() );
     return true;
@@ -300,21 +493,14 @@ been loaded yet (collection isn't initialised)" << std::endl;
 #endif
 
     // get new active level pointer
-    std::size_t newActiveLevel = -1;
-    for( std::size_t i = 0; i != m_Levels.size(); ++i )
-    {
-        if( m_Levels[i]->getLevelName().compare( levelName ) == 0 )
-        {
-            newActiveLevel = i;
-            break;
-        }
-    }
+    std::size_t newActiveLevel = this->findLevel( levelName );
 
     // none found
-    if( newActiveLevel == -1 )
+    if( newActiveLevel == NO_LEVEL )
         throw Exception( std::string("[Collection::setActiveLevel] Error: Level name \"") + levelName + "\" was not found in loaded collection" );
 
     // prepare the level to play on
+    this->parseLevel( m_Levels[newActiveLevel] );
     m_Levels[newActiveLevel]->validateLevel();
     m_Levels[newActiveLevel]->reset();
     m_Levels[newActiveLevel]->applyUndoData();
@@ -327,37 +513,41 @@ been loaded yet (collection isn't initialised)" << std::endl;
 // --------------------------------------------------------------
 bool Collection::hasActiveLevel( void )
 {
-    return ( m_ActiveLevel != -1 );
+    return ( m_ActiveLevel != NO_LEVEL );
 }
 
 // --------------------------------------------------------------
 Collection::level_iterator Collection::level_begin( void )
 {
+    this->parseAllLevels();
     return m_Levels.begin();
 }
 
 // --------------------------------------------------------------
 Collection::level_iterator Collection::level_end( void )
 {
+    this->parseAllLevels();
     return m_Levels.end();
 }
 
 // --------------------------------------------------------------
 const Collection::const_level_iterator Collection::level_begin( void ) const
 {
+    this->parseAllLevels();
     return m_Levels.begin();
 }
 
 // --------------------------------------------------------------
 const Collection::const_level_iterator Collection::level_end( void ) const
 {
+    this->parseAllLevels();
     return m_Levels.end();
 }
 
 // --------------------------------------------------------------
 void Collection::getTileData( Array2D<char>& tiles ) const
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::getTileData] Error: Attempt to get tile data without first setting an active level" << std::endl;
@@ -370,7 +560,7 @@ void Collection::getTileData( Array2D<char>& tiles ) const
 // --------------------------------------------------------------
 void Collection::streamTileData( std::ostream& stream )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::streamTiledata] Warning: Attempt to stream tile data without first setting an active level" << std::endl;
@@ -383,7 +573,7 @@ void Collection::streamTileData( std::ostream& stream )
 // --------------------------------------------------------------
 char Collection::getTile( const Uint32 x, const Uint32 y )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
         throw Exception( "[Collection::getTile] Error: Attempt to get tile without first setting an active level" );
     return m_Levels[m_ActiveLevel]->getTile( x, y );
 }
@@ -391,7 +581,7 @@ char Collection::getTile( const Uint32 x, const Uint32 y )
 // --------------------------------------------------------------
 void Collection::setTile( const Uint32 x, const Uint32 y, const char tile )
 {
-   if( m_ActiveLevel == -1 )
+   if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::setTile] Warning: Attempt to set a tile without first setting an active level" << std::endl;
@@ -404,7 +594,7 @@ void Collection::setTile( const Uint32 x, const Uint32 y, const char tile )
 // --------------------------------------------------------------
 Uint32 Collection::getSizeX( void ) const
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
         throw Exception( "[Collection::getSizeX] Error: No active level set" );
     return m_Levels[m_ActiveLevel]->getSizeX();
 }
@@ -412,7 +602,7 @@ Uint32 Collection::getSizeX( void ) const
 // --------------------------------------------------------------
 Uint32 Collection::getSizeY( void ) const
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
         throw Exception( "[Collection::getSizeY] Error: No active level set" );
     return m_Levels[m_ActiveLevel]->getSizeY();
 }
@@ -420,7 +610,8 @@ Uint32 Collection::getSizeY( void ) const
 // --------------------------------------------------------------
 Uint32 Collection::getMaxSizeX( void )
 {
-    Uint32 max;
+    this->parseAllLevels();
+    Uint32 max = 0;
     for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
         if( (*it)->getSizeX() > max ) max = (*it)->getSizeX();
     return max;
@@ -429,7 +620,8 @@ Uint32 Collection::getMaxSizeX( void )
 // --------------------------------------------------------------
 Uint32 Collection::getMaxSizeY( void )
 {
-    Uint32 max;
+    this->parseAllLevels();
+    Uint32 max = 0;
     for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
         if( (*it)->getSizeY() > max ) max = (*it)->getSizeY();
     return max;
@@ -461,7 +653,7 @@ void Collection::removeLevelListener( LevelListener* listener )
 // --------------------------------------------------------------
 void Collection::moveUp( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::moveUp] Warning: No active level set" << std::endl;
@@ -474,7 +666,7 @@ void Collection::moveUp( void )
 // --------------------------------------------------------------
 void Collection::moveDown( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::moveDown] Warning: No active level set" << std::endl;
@@ -487,7 +679,7 @@ void Collection::moveDown( void )
 // --------------------------------------------------------------
 void Collection::moveLeft( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::moveLeft] Warning: No active level set" << std::endl;
@@ -500,7 +692,7 @@ void Collection::moveLeft( void )
 // --------------------------------------------------------------
 void Collection::moveRight( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::moveRight] Warning: No active level set" << std::endl;
@@ -513,7 +705,7 @@ void Collection::moveRight( void )
 // --------------------------------------------------------------
 void Collection::undo( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::undo] Warning: No active level set" << std::endl;
@@ -526,7 +718,7 @@ void Collection::undo( void )
 // --------------------------------------------------------------
 void Collection::redo( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::redo] Warning: No active level set" << std::endl;
@@ -539,7 +731,7 @@ void Collection::redo( void )
 // --------------------------------------------------------------
 void Collection::reset( void )
 {
-    if( m_ActiveLevel == -1 )
+    if( m_ActiveLevel == NO_LEVEL )
     {
 #ifdef _DEBUG
         std::cout << "[Collection::reset] Warning: No active level set" << std::endl;
@@ -564,6 +756,59 @@ void Collection::onMoveTile( const std::size_t& oldX, const std::size_t& oldY, c
         (*it)->onMoveTile( oldX, oldY, newX, newY );
 }
 
+// --------------------------------------------------------------
+void Collection::onReplaceBoard( void )
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+        (*it)->onReplaceBoard();
+}
+
+// --------------------------------------------------------------
+void Collection::onDeadlock( const std::size_t& x, const std::size_t& y, const DeadlockDetector::Type& type )
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+        (*it)->onDeadlock( x, y, type );
+}
+
+// --------------------------------------------------------------
+void Collection::onSetLevelName( const Level& level, const std::string& oldName )
+{
+    std::unordered_map<std::string, LevelSlot>::iterator it = m_LevelIndex.find( oldName );
+    if( it == m_LevelIndex.end() )
+        return;
+
+    // usually the renamed level is the first with its old name. Otherwise
+    // the old name is shared and the level has to be searched for.
+    std::size_t slot = it->second.index;
+    if( m_Levels[slot] != &level )
+    {
+        for( slot = 0; slot != m_Levels.size(); ++slot )
+            if( m_Levels[slot] == &level )
+                break;
+        if( slot == m_Levels.size() )
+            return;
+        --it->second.count;
+    }
+    else if( it->second.count == 1 )
+        m_LevelIndex.erase( it );
+    else
+    {
+        --it->second.count;
+        do{
+            ++it->second.index;
+        }while( m_Levels[it->second.index]->getLevelName() != oldName );
+    }
+
+    // a generated name may have been freed
+    if( oldName.compare( 0, 7, "Level #" ) == 0 )
+        m_NextLevelNumber = 1;
+
+    this->indexLevel( slot );
+
+    for( std::vector<LevelListener*>::iterator listener = m_LevelListeners.begin(); listener != m_LevelListeners.end(); ++listener )
+        (*listener)->onSetLevelName( level, oldName );
+}
+
 // --------------------------------------------------------------
 Collection& Collection::operator=( const Collection& that )
 {
@@ -574,21 +819,77 @@ Collection& Collection::operator=( const Collection& that )
     this->m_CollectionName = that.m_CollectionName;
     this->m_LevelListeners = that.m_LevelListeners;
     this->m_EnableCompression = that.m_EnableCompression;
+    this->m_EnableLazyLoading = that.m_EnableLazyLoading;
+    this->m_NumParserThreads = that.m_NumParserThreads;
     this->m_IsLoaded = that.m_IsLoaded;
 
-    // destroy levels
+    // destroy levels and release their memory
     for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
-        delete *it;
+        m_LevelPool.destroy( *it );
+    m_LevelPool.clear();
     m_Levels.clear();
+    m_LevelSources.clear();
     m_ActiveLevel = 0;
 
     // deep copy level objects
     // memory has already been allocated for level objects in copy constructor
+    // the copies report to this collection instead of the original
     for( std::size_t i = 0; i != that.m_Levels.size(); ++i )
-        m_Levels.push_back( new Level(*(that.m_Levels[i])) );
+    {
+        m_Levels.push_back( m_LevelPool.construct( *that.m_Levels[i] ) );
+        m_Levels.back()->removeListener( const_cast<Collection*>( &that ) );
+        m_Levels.back()->addListener( this );
+    }
+    this->rebuildLevelIndex();
 
+    // levels which haven't been parsed yet keep sharing the source file
+    for( std::size_t i = 0; i != that.m_Levels.size(); ++i )
+    {
+        std::map<const Level*, LevelSource>::const_iterator it = that.m_LevelSources.find( that.m_Levels[i] );
+        if( it != that.m_LevelSources.end() )
+            m_LevelSources[m_Levels[i]] = it->second;
+    }
+    m_SourceFile = that.m_SourceFile;
+
+#ifdef _DEBUG
     std::cout << "copying collection" << std::endl;
+#endif
+
+    return *this;
+}
 
+// --------------------------------------------------------------
+Collection& Collection::operator=( Collection&& that ) noexcept
+{
+    this->swap( that );
+    return *this;
+}
+
+// --------------------------------------------------------------
+void Collection::swap( Collection& that ) noexcept
+{
+    if( this == &that ) return;
+
+    m_FileName.swap( that.m_FileName );
+    m_CollectionName.swap( that.m_CollectionName );
+    m_LevelPool.swap( that.m_LevelPool );
+    m_Levels.swap( that.m_Levels );
+    m_LevelListeners.swap( that.m_LevelListeners );
+    m_LevelIndex.swap( that.m_LevelIndex );
+    m_LevelSources.swap( that.m_LevelSources );
+    m_SourceFile.swap( that.m_SourceFile );
+    std::swap( m_ActiveLevel, that.m_ActiveLevel );
+    std::swap( m_NumParserThreads, that.m_NumParserThreads );
+    std::swap( m_NextLevelNumber, that.m_NextLevelNumber );
+    std::swap( m_EnableCompression, that.m_EnableCompression );
+    std::swap( m_EnableLazyLoading, that.m_EnableLazyLoading );
+    std::swap( m_IsLoaded, that.m_IsLoaded );
+
+    // the levels changed hands, so they have to report to their new owners
+    for( std::vector<Level*>::iterator it = m_Levels.begin(); it != m_Levels.end(); ++it )
+        (*it)->replaceListener( &that, this );
+    for( std::vector<Level*>::iterator it = that.m_Levels.begin(); it != that.m_Levels.end(); ++it )
+        (*it)->replaceListener( this, &that );
 }
 
 } // namespace Chocobun
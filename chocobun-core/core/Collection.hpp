@@ -29,8 +29,13 @@
 #include <core/Export.hpp>
 #include <core/LevelListener.hpp>
 #include <core/CollectionParser.hpp>
+#include <core/CollectionParserBase.hpp>
+#include <core/ObjectPool.hxx>
 #include <vector>
 #include <string>
+#include <map>
+#include <unordered_map>
+#include <memory>
 
 namespace Chocobun {
 
@@ -38,6 +43,7 @@ namespace Chocobun {
 // forward declarations
 
 class Level;
+class MappedFile;
 
 /*!
  * @brief Holds a collection of levels which can be read from a file
@@ -63,6 +69,13 @@ public:
      */
     Collection( const Collection& that );
 
+    /*!
+     * @brief Move Constructor
+     * Takes over all levels of the other collection without copying them.
+     * The other collection is left empty.
+     */
+    Collection( Collection&& that ) noexcept;
+
     /*!
      * @brief Destructor
      * Unloads everything (this calls @a unload)
@@ -73,7 +86,8 @@ public:
      * @brief Initialises the collection
      *
      * Will parse the file specified in the constructor and load all
-     * levels into memory
+     * levels into memory. If lazy loading is enabled, only the names of the
+     * levels are read, see @a enableLazyLoading.
      */
     void load( const std::string& fileName );
 
@@ -141,6 +155,70 @@ public:
      */
     bool isCompressionEnabled( void ) const;
 
+    /*!
+     * @brief Enables lazy loading of levels
+     *
+     * When enabled, @a load only scans the file for the names and locations
+     * of the levels. The tile data, notes and snapshot of a level are parsed
+     * the first time the level is accessed, and the file stays mapped into
+     * memory until then. Has no effect on collections which are already
+     * loaded, or on formats other than SOK.
+     *
+     * @note Default is <b>disabled</b>
+     */
+    void enableLazyLoading( void );
+
+    /*!
+     * @brief Disables lazy loading of levels
+     *
+     * @note Default is <b>disabled</b>
+     */
+    void disableLazyLoading( void );
+
+    /*!
+     * @brief Checks if lazy loading is enabled or not
+     * @return Returns true if lazy loading is enabled, false if not
+     */
+    bool isLazyLoadingEnabled( void ) const;
+
+    /*!
+     * @brief Sets the number of threads used to parse levels
+     *
+     * With more than one thread, @a load first scans the file for the names
+     * and locations of the levels like lazy loading does, and then parses
+     * the levels in parallel. Levels are named exactly as when parsing with
+     * a single thread. Also applies when parsing the remaining levels of a
+     * lazily loaded collection. Only affects the SOK format.
+     *
+     * @param numThreads The number of threads. Set to 0 to use one thread
+     * per hardware thread.
+     * @note Default is <b>1</b>
+     */
+    void setNumParserThreads( const std::size_t& numThreads );
+
+    /*!
+     * @brief Gets the number of threads used to parse levels
+     */
+    const std::size_t& getNumParserThreads( void ) const;
+
+    /*!
+     * @brief Marks a level as not parsed yet
+     *
+     * Used by parsers when loading lazily. The level is parsed from the
+     * source file once it is accessed.
+     *
+     * @param lvl A level of this collection which only has its name set
+     * @param source The location of the level in the source file
+     */
+    void deferLevel( Level* lvl, const LevelSource& source );
+
+    /*!
+     * @brief Sets the file deferred levels are parsed from
+     *
+     * The file is released as soon as no deferred levels remain.
+     */
+    void setSourceFile( const std::shared_ptr<MappedFile>& file );
+
     /*!
      * @brief Adds a new, empty level to the collection
      */
@@ -234,6 +312,7 @@ public:
 
     /*!
      * @brief Expose begin iterator for access to all levels
+     * Any levels which haven't been parsed yet are parsed first.
      */
     level_iterator level_begin( void );
 
@@ -244,6 +323,8 @@ public:
 
     /*!
      * @brief Expose constant begin iterator for access to all levels
+     * Any levels which haven't been parsed yet are parsed first, so the
+     * levels can be saved from a constant collection.
      */
     const const_level_iterator level_begin( void ) const;
 
@@ -256,7 +337,7 @@ public:
      * @brief Returns all tiles of the active level
      *
      * All tiles of the active level are contained within a dynamic 2-dimensional
-     * array or chars (std::vector< std::vector<char> >).
+     * array of chars stored contiguously in row-major order (see Array2D).
      *
      * <b>Valid tiles are:</b>
      * - # Wall
@@ -415,19 +496,107 @@ public:
      */
     void onMoveTile( const std::size_t& oldX, const std::size_t& oldY, const std::size_t& newX, const std::size_t& newY );
 
+    /*!
+     * @brief Level listener for many tiles being changed at once
+     */
+    void onReplaceBoard( void );
+
+    /*!
+     * @brief Level listener for pushes leading to deadlocks
+     */
+    void onDeadlock( const std::size_t& x, const std::size_t& y, const DeadlockDetector::Type& type );
+
+    /*!
+     * @brief Level listener for levels being renamed
+     * Keeps the name index up to date.
+     */
+    void onSetLevelName( const Level& level, const std::string& oldName );
+
     /*!
      * @brief Overload assignment operator
      */
     Collection& operator=( const Collection& that );
 
+    /*!
+     * @brief Overload move assignment operator
+     * Exchanges the contents of both collections, see @a swap
+     */
+    Collection& operator=( Collection&& that ) noexcept;
+
+    /*!
+     * @brief Exchanges the contents of two collections without copying them
+     * The levels stay where they are in memory and report to the
+     * collection they belong to afterwards.
+     */
+    void swap( Collection& that ) noexcept;
+
 private:
 
+    /*!
+     * @brief Used as the position of a level when there is no level, see
+     * @a findLevel and @a m_ActiveLevel
+     */
+    static const std::size_t NO_LEVEL;
+
+    /*!
+     * @brief Parses a level if it was deferred while loading
+     */
+    void parseLevel( Level* lvl );
+
+    /*!
+     * @brief Parses all levels which were deferred while loading
+     * The levels are distributed over the parser threads. Parsing only fills
+     * in levels which already exist, so this is allowed on constant
+     * collections.
+     */
+    void parseAllLevels( void ) const;
+
+    /*!
+     * @brief Removes and destroys the level at the specified position
+     */
+    void destroyLevel( const std::size_t& slot );
+
+    /*!
+     * @brief Gets the position of the first level with the specified name
+     * @return The position in the level list, or NO_LEVEL if no level has the name
+     */
+    std::size_t findLevel( const std::string& levelName ) const;
+
+    /*!
+     * @brief Adds the level at the specified position to the name index
+     */
+    void indexLevel( const std::size_t& slot );
+
+    /*!
+     * @brief Rebuilds the name index from scratch
+     * This is required whenever levels change their positions.
+     */
+    void rebuildLevelIndex( void );
+
+    /*!
+     * @brief Entry of the name index
+     * Names can be shared by several levels, in which case the first of them
+     * is found by name.
+     */
+    struct LevelSlot
+    {
+        std::size_t index;  // position of the first level with the name
+        std::size_t count;  // number of levels with the name
+    };
+
     std::string m_FileName;
     std::string m_CollectionName;
+    ObjectPool<Level> m_LevelPool;
     std::vector<Level*> m_Levels;
     std::vector<LevelListener*> m_LevelListeners;
+    std::unordered_map<std::string, LevelSlot> m_LevelIndex;
+    mutable std::map<const Level*, LevelSource> m_LevelSources;
+    mutable std::shared_ptr<MappedFile> m_SourceFile;
     std::size_t m_ActiveLevel;
+    std::size_t m_NumParserThreads;
+    Uint32 m_NextLevelNumber;
     bool m_EnableCompression;
+    bool m_EnableLazyLoading;
     bool m_IsLoaded;
 };
 
@@ -28,6 +28,8 @@
 #include <core/CollectionParserSLC.hpp>
 #include <core/RLE.hpp>
 #include <core/Level.hpp>
+#include <core/MappedFile.hpp>
+#include <core/StringView.hpp>
 #include <core/Exception.hpp>
 #include <core/Config.hpp>
 #include <fstream>
@@ -51,30 +53,61 @@ CollectionParser::~CollectionParser( void )
 void CollectionParser::parse( const std::string& fileName, Collection& collection )
 {
 
-    // open the file
-    std::ifstream file( fileName.c_str() );
-    if( !file.is_open() )
+    // map the file, parsers read it straight from memory. The mapping is
+    // shared with the collection if levels are loaded lazily
+    std::shared_ptr<MappedFile> file( new MappedFile() );
+    try
+    {
+        file->open( fileName );
+    }
+    catch( const Exception& )
+    {
         throw Exception( "[CollectionParser::parse] Error: attempt to open collection file failed" );
-
-    std::string inBuf("");
-    std::getline( file, inBuf );
-    file.seekg( 0 ); // reset file pointer
+    }
 
-    // wrap pointer into smart pointer so exceptions can be thrown
+    // wrap pointer into smart pointer so exceptions can be thrown
     // without memory leaks
-    std::auto_ptr<CollectionParserBase> parser;
+    std::auto_ptr<CollectionParserBase> parser( this->createParser( *file ) );
+
+    // parse
+    parser->parse( *file, collection );
+    collection.setSourceFile( file );
+}
 
-    if( "<?xml" == inBuf.substr(0,5) ) // if the file starts with the xml magic bytes, we assume the format is SLC...
+// --------------------------------------------------------------
+void CollectionParser::parse( const std::string& fileName, CollectionParserListener& listener )
+{
+    MappedFile file;
+    try
     {
-        parser = std::auto_ptr<CollectionParserBase>( new CollectionParserSLC() );
+        file.open( fileName );
     }
-    else // ... else we assume the file format is SOK
+    catch( const Exception& )
     {
-        parser = std::auto_ptr<CollectionParserBase>( new CollectionParserSOK() );
+        throw Exception( "[CollectionParser::parse] Error: attempt to open collection file failed" );
     }
 
-    // parse
-    parser->parse( file, collection );
+    std::auto_ptr<CollectionParserBase> parser( this->createParser( file ) );
+    parser->parse( file, listener );
+}
+
+// --------------------------------------------------------------
+CollectionParserBase* CollectionParser::createParser( const MappedFile& file )
+{
+    if( StringView( file.data(), file.size() ).substr(0,5).equals("<?xml") ) // if the file starts with the xml magic bytes, we assume the format is SLC...
+        return new CollectionParserSLC();
+
+    // ... else we assume the file format is SOK
+    return new CollectionParserSOK();
+}
+
+// --------------------------------------------------------------
+void CollectionParser::parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl )
+{
+
+    // only the SOK parser defers levels
+    CollectionParserSOK parser;
+    parser.parseLevel( file, source, lvl );
 }
 
 // --------------------------------------------------------------
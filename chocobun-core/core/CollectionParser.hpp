@@ -35,6 +35,10 @@ namespace Chocobun {
 
 class Level;
 class Collection;
+class MappedFile;
+class CollectionParserBase;
+class CollectionParserListener;
+struct LevelSource;
 
 /*!
  * @brief Parses a collection and loads all levels into an internal format
@@ -63,6 +67,27 @@ public:
      */
     void parse( const std::string& fileName, Collection& collection );
 
+    /*!
+     * @brief Streams a collection file to a listener
+     *
+     * Unlike parsing into a collection, no levels are constructed. This is
+     * useful for tools which only need to scan, count, index or convert
+     * levels, as SOK files of any size are processed in constant memory.
+     *
+     * @param fileName The name of the file to parse
+     * @param listener The listener to send the contents of the file to
+     */
+    void parse( const std::string& fileName, CollectionParserListener& listener );
+
+    /*!
+     * @brief Parses a single level which was skipped when loading lazily
+     *
+     * @param file The memory mapped collection file
+     * @param source The location of the level in the file
+     * @param lvl The level to load into
+     */
+    void parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl );
+
     /*!
      * @brief Saves a collection to a file
      *
@@ -90,6 +115,12 @@ public:
 
 private:
 
+    /*!
+     * @brief Creates the parser for the format of a file
+     * The format is detected from the contents of the file.
+     */
+    CollectionParserBase* createParser( const MappedFile& file );
+
     std::string m_FileFormat;
 
 };
@@ -26,6 +26,8 @@
 #include <core/Config.hpp>
 #include <core/CollectionParserBase.hpp>
 #include <core/Level.hpp>
+#include <core/MappedFile.hpp>
+#include <core/Exception.hpp>
 
 #include <sstream>
 
@@ -69,7 +71,7 @@ void CollectionParserBase::_registerLevel( Level* level, std::string& levelName,
 }*/
 
 // --------------------------------------------------------------
-void CollectionParserBase::parse( std::ifstream& file, Collection& collection )
+void CollectionParserBase::parse( const MappedFile& file, Collection& collection )
 {
 
     // left empty for future use
@@ -80,6 +82,24 @@ void CollectionParserBase::parse( std::ifstream& file, Collection& collection )
     return this->_parse( file, collection );
 }
 
+// --------------------------------------------------------------
+void CollectionParserBase::parse( const MappedFile& file, CollectionParserListener& listener )
+{
+    this->_parse( file, listener );
+}
+
+// --------------------------------------------------------------
+void CollectionParserBase::parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl )
+{
+    this->_parseLevel( file, source, lvl );
+}
+
+// --------------------------------------------------------------
+void CollectionParserBase::_parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl )
+{
+    throw Exception( "[CollectionParserBase::parseLevel] Error: this format doesn't support lazy loading" );
+}
+
 // --------------------------------------------------------------
 void CollectionParserBase::save( std::ofstream& file, const Collection& collection )
 {
@@ -36,6 +36,18 @@ namespace Chocobun {
 
 class Collection;
 class Level;
+class MappedFile;
+class CollectionParserListener;
+
+/*!
+ * @brief Location of a level in a collection file which hasn't been parsed yet
+ */
+struct LevelSource
+{
+    std::size_t begin;  //!< Offset of the first character of the level
+    std::size_t end;    //!< Offset of the first character after the level
+    std::vector<std::string> titles; //!< Lines which turned out to be level titles
+};
 
 /*!
  * @brief Base class for all collection parsers
@@ -72,14 +84,36 @@ public:
      *
      * This method calls the abstract method _parse
      *
-     * @param file An open file input stream object, ready to read from
+     * @param file An open memory mapped file to read from
      * @param levels An empty vector in which the newly constructed levels can be
      * saved
      * @return Must return the name of the collection, so the host application is able
      * to display it. If no collection name is available, it is recommended to return
      * "collection".
      */
-    void parse( std::ifstream& file, Collection& collection );
+    void parse( const MappedFile& file, Collection& collection );
+
+    /*!
+     * @brief Parses a single level which was skipped when loading lazily
+     *
+     * This method calls the virtual method _parseLevel
+     *
+     * @param file The memory mapped file the level was found in
+     * @param source The location of the level in the file
+     * @param lvl The level to load into
+     */
+    void parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl );
+
+    /*!
+     * @brief Streams the contents of a file to a listener
+     *
+     * No levels are constructed, so files of any size can be processed.
+     * This method calls the abstract method _parse
+     *
+     * @param file An open memory mapped file to read from
+     * @param listener The listener to send the contents to
+     */
+    void parse( const MappedFile& file, CollectionParserListener& listener );
 
     /*!
      * @brief Enables compression of exported files
@@ -105,14 +139,37 @@ protected:
      *
      * This method is pure virtual and must be implemented by the inheriting class.
      *
-     * @param file An open file input stream object, ready to read from
+     * @param file An open memory mapped file to read from
      * @param levels An empty vector in which the newly constructed levels can be
      * saved
      * @return Must return the name of the collection, so the host application is able
      * to display it. If no collection name is available, it is recommended to return
      * "collection".
      */
-    virtual void _parse( std::ifstream& file, Collection& collection ) = 0;
+    virtual void _parse( const MappedFile& file, Collection& collection ) = 0;
+
+    /*!
+     * @brief Streams the contents of a file to a listener
+     *
+     * This method is pure virtual and must be implemented by the inheriting class.
+     *
+     * @param file An open memory mapped file to read from
+     * @param listener The listener to send the contents to
+     */
+    virtual void _parse( const MappedFile& file, CollectionParserListener& listener ) = 0;
+
+    /*!
+     * @brief Parses a single level which was skipped when loading lazily
+     *
+     * Parsers which support lazy loading record the location of each level
+     * with Collection::deferLevel and must override this method.
+     *
+     * @exception Chocobun::Exception if the parser doesn't support lazy loading
+     * @param file The memory mapped file the level was found in
+     * @param source The location of the level in the file
+     * @param lvl The level to load into
+     */
+    virtual void _parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl );
 
     /*!
      * @brief Saves a vector of level objects to a file
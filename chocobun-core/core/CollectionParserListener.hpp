@@ -0,0 +1,100 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// CollectionParserListener.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_COLLECTION_PARSER_LISTENER_HPP__
+#define __CHOCOBUN_CORE_COLLECTION_PARSER_LISTENER_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <string>
+
+namespace Chocobun {
+
+/*!
+ * @brief Listener interface class for streaming collection files
+ *
+ * Receives the contents of a collection file in the order they appear in,
+ * without any levels being constructed (see CollectionParser::parse). The
+ * strings passed are only valid during the call.
+ *
+ * Events received before the first @a onLevelBegin belong to the header of
+ * the file. All other events belong to the level that was last begun.
+ */
+class CollectionParserListener
+{
+public:
+
+    /*!
+     * @brief Destructor
+     */
+    virtual ~CollectionParserListener( void ){}
+
+    /*!
+     * @brief When the name of the collection is found
+     */
+    virtual void onCollectionName( const std::string& name ){}
+
+    /*!
+     * @brief When a line of text is found in the header of the file
+     */
+    virtual void onHeaderData( const std::string& header ){}
+
+    /*!
+     * @brief When a new level begins
+     * @param levelName The title of the level as found in the file. Empty if
+     * the level has no title, in which case Collection::generateLevelName
+     * would give it one.
+     */
+    virtual void onLevelBegin( const std::string& levelName ){}
+
+    /*!
+     * @brief When a row of tiles is found, from top to bottom
+     * @param tiles The tiles in conventional notation, already decompressed
+     */
+    virtual void onTileRow( const std::string& tiles ){}
+
+    /*!
+     * @brief When a key-value pair is found
+     */
+    virtual void onMetaData( const std::string& key, const std::string& value ){}
+
+    /*!
+     * @brief When a snapshot of undo data is found
+     * @param undoData The undo data, in the format of Level::importUndoData
+     */
+    virtual void onSnapshot( const std::string& undoData ){}
+
+    /*!
+     * @brief When a line of text is found in a level
+     */
+    virtual void onNote( const std::string& note ){}
+
+    /*!
+     * @brief When the current level ends
+     */
+    virtual void onLevelEnd( void ){}
+
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_COLLECTION_PARSER_LISTENER_HPP__
@@ -29,7 +29,9 @@
 #include <core/Collection.hpp>
 #include <core/CollectionParserSLC.hpp>
 #include <core/Level.hpp>
+#include <core/MappedFile.hpp>
 #include <core/Exception.hpp>
+#include <core/CollectionParserListener.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -55,12 +57,11 @@ CollectionParserSLC::~CollectionParserSLC( void )
 }
 
 // --------------------------------------------------------------
-void CollectionParserSLC::_parse( std::ifstream& file, Collection& collection )
+rapidxml::xml_node<>* CollectionParserSLC::parseDocument( const MappedFile& file, std::vector<char>& buffer, rapidxml::xml_document<>& doc )
 {
-    rapidxml::xml_document<> doc;
 
-    // Read file into vector<char>
-    std::vector<char> buffer( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>( ) );
+    // rapidxml parses in place, so it needs a writable copy of the file
+    buffer.assign( file.data(), file.data() + file.size() );
     buffer.push_back( '\0' );
 
     try
@@ -73,7 +74,15 @@ void CollectionParserSLC::_parse( std::ifstream& file, Collection& collection )
         throw Exception( std::string("Error during xml parsing: ") + e.what() );
     }
 
-    rapidxml::xml_node<>* rootNode = getFirstNode( &doc, "SokobanLevels" );
+    return getFirstNode( &doc, "SokobanLevels" );
+}
+
+// --------------------------------------------------------------
+void CollectionParserSLC::_parse( const MappedFile& file, Collection& collection )
+{
+    rapidxml::xml_document<> doc;
+    std::vector<char> buffer;
+    rapidxml::xml_node<>* rootNode = this->parseDocument( file, buffer, doc );
 
     // read all the meta tags into the metaTagValues array
     std::string metaTagValues [NUM_META_TAG_NAMES];
@@ -90,11 +99,12 @@ void CollectionParserSLC::_parse( std::ifstream& file, Collection& collection )
 
     std::string levelCollectionCopyright = getFirstAttribute(levelCollectionNode, "Copyright");
 
+    std::vector<std::string> lines;
     for( rapidxml::xml_node<>* levelNode = levelCollectionNode->first_node("Level"); levelNode; levelNode = levelNode->next_sibling() )
     {
         std::string levelName = getFirstAttribute(levelNode, "Id");
 
-        Level* lvl; // = listener->_constructNewLevel();
+        Level* lvl = collection.addLevel();
 
         lvl->addMetaData("Author", levelCollectionCopyright);
 
@@ -104,20 +114,68 @@ void CollectionParserSLC::_parse( std::ifstream& file, Collection& collection )
             lvl->addMetaData(META_TAG_NAMES[i], metaTagValues[i]);
         }
 
-        //listener->_generateLevelName( levelName );
+        collection.generateLevelName( levelName );
         lvl->setLevelName( levelName );
 
-        int y = 0;
-
+        // collect all lines first so the level is built in one go, reusing
+        // the strings of the previous level
+        std::size_t numLines = 0;
         for( rapidxml::xml_node<>* levelLineNode = levelNode->first_node("L"); levelLineNode; levelLineNode = levelLineNode->next_sibling() )
         {
-            lvl->insertTileLine(y++, levelLineNode->value());
+            if( lines.size() == numLines )
+                lines.resize( numLines+1 );
+            lines[numLines] = levelLineNode->value();
+            this->convertTilesToConventional( lines[numLines] );
+            ++numLines;
         }
+        lines.resize( numLines );
+        lvl->insertTileLines( 0, lines );
     }
 
     //TODO return metaTagValues[0];
 }
 
+// --------------------------------------------------------------
+void CollectionParserSLC::_parse( const MappedFile& file, CollectionParserListener& listener )
+{
+    rapidxml::xml_document<> doc;
+    std::vector<char> buffer;
+    rapidxml::xml_node<>* rootNode = this->parseDocument( file, buffer, doc );
+
+    // the title of the collection doubles as its name
+    std::string metaTagValues [NUM_META_TAG_NAMES];
+    for( int i = 0; i < NUM_META_TAG_NAMES; ++i )
+    {
+        rapidxml::xml_node<>* metaTag = getFirstNode( rootNode, META_TAG_NAMES[i] );
+        if( metaTag != 0 )
+            metaTagValues[i] = metaTag->value();
+    }
+    listener.onCollectionName( metaTagValues[0] );
+
+    rapidxml::xml_node<>* levelCollectionNode = getFirstNode(rootNode, "LevelCollection");
+    std::string levelCollectionCopyright = getFirstAttribute(levelCollectionNode, "Copyright");
+
+    std::string tiles;
+    for( rapidxml::xml_node<>* levelNode = levelCollectionNode->first_node("Level"); levelNode; levelNode = levelNode->next_sibling() )
+    {
+        listener.onLevelBegin( getFirstAttribute(levelNode, "Id") );
+
+        // the meta tags of the collection apply to every level
+        listener.onMetaData( "Author", levelCollectionCopyright );
+        for( int i = 0; i < NUM_META_TAG_NAMES; ++i )
+            listener.onMetaData( META_TAG_NAMES[i], metaTagValues[i] );
+
+        for( rapidxml::xml_node<>* levelLineNode = levelNode->first_node("L"); levelLineNode; levelLineNode = levelLineNode->next_sibling() )
+        {
+            tiles = levelLineNode->value();
+            this->convertTilesToConventional( tiles );
+            listener.onTileRow( tiles );
+        }
+
+        listener.onLevelEnd();
+    }
+}
+
 // --------------------------------------------------------------
 void CollectionParserSLC::_save( std::ofstream& file, const Collection& collection )
 {
@@ -65,7 +65,29 @@ private:
      * @return Returns the name of the collection (if any), otherwise the string
      * is empty
      */
-    void _parse( std::ifstream& file, Collection& collection );
+    void _parse( const MappedFile& file, Collection& collection );
+
+    /*!
+     * @brief Streams a .SLC file to a listener
+     *
+     * The XML document is parsed as a whole first, so unlike the SOK
+     * parser this needs memory proportional to the size of the file.
+     *
+     * @param file An open memory mapped file to read from
+     * @param listener The listener to send the contents to
+     */
+    void _parse( const MappedFile& file, CollectionParserListener& listener );
+
+    /*!
+     * @brief Parses the XML document of a file
+     *
+     * @param file An open memory mapped file to read from
+     * @param buffer Receives the copy of the file rapidxml parses in place.
+     * Must outlive the document.
+     * @param doc The document to parse into
+     * @return The root node of the document
+     */
+    rapidxml::xml_node<>* parseDocument( const MappedFile& file, std::vector<char>& buffer, rapidxml::xml_document<>& doc );
 
     /* !
      * @brief .SLC format exporter
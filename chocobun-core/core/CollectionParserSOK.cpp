@@ -27,6 +27,9 @@
 #include <core/CollectionParserSOK.hpp>
 #include <core/Level.hpp>
 #include <core/RLE.hpp>
+#include <core/MappedFile.hpp>
+#include <core/LineReader.hpp>
+#include <core/CollectionParserListener.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -46,10 +49,10 @@ CollectionParserSOK::~CollectionParserSOK( void )
 }
 
 // --------------------------------------------------------------
-bool CollectionParserSOK::getKeyValuePair( const std::string& str, std::string& key, std::string& value )
+bool CollectionParserSOK::getKeyValuePair( const StringView& str, StringView& key, StringView& value )
 {
 
-    size_t pos = str.find( ":" ); // key-value pairs are split by a colon
+    size_t pos = str.find( ':' ); // key-value pairs are split by a colon
     if( pos == std::string::npos )
         return false;
 
@@ -59,47 +62,129 @@ bool CollectionParserSOK::getKeyValuePair( const std::string& str, std::string&
     if( str.find( "::" ) != std::string::npos ) // comments are not permitted
         return false;
 
-    // extract key and value
-    key = str.substr(0, pos);
-    value = str.substr(pos+1, str.size()-pos);
-
-    // trim key and value from leading and trailing spaces
-    size_t strBegin = key.find_first_not_of( " " );
-    size_t strEnd = key.find_last_not_of( " " );
-    key = key.substr(strBegin, strEnd-strBegin+1);
-    strBegin = value.find_first_not_of( " " );
-    strEnd = value.find_last_not_of( " " );
-    value = value.substr(strBegin, strEnd-strBegin+1);
+    // extract key and value, trimmed from leading and trailing spaces
+    key = str.substr( 0, pos ).trim();
+    value = str.substr( pos+1 ).trim();
 
     return true;
 }
 
 // --------------------------------------------------------------
-void CollectionParserSOK::_parse( std::ifstream& file, Collection& collection )
-{
-#ifdef _DEBUG
-    std::cout << "parsing SOK" << std::endl;
+void CollectionParserSOK::removeTabs( StringView& line, std::string& buffer )
+{
+    if( line.find( '\t' ) == std::string::npos )
+        return;
+    buffer.assign( line.data(), line.size() );
+    buffer.erase(std::remove(buffer.begin(), buffer.end(), '\t'), buffer.end());
+    line = StringView( buffer );
+}
+
+// --------------------------------------------------------------
+void CollectionParserSOK::processLine( const StringView& line, const bool& isLevelData, const bool& levelDataReadForFirstTime, Uint32& tileLine, Level& lvl, Collection* collection )
+{
+
+    // determine if if is level data
+    if( isLevelData )
+    {
+
+        // the lines are inserted all at once by insertTileLines when the
+        // level ends. Their strings are kept to be reused by the next level.
+        // Compressed levels are saved on a single line, with the rows
+        // separated by '|'.
+        m_Tiles.clear();
+        m_RLE.decompress( line.data(), line.size(), m_Tiles );
+        this->convertTilesToConventional( m_Tiles );
+        for( std::size_t begin = 0; begin != m_Tiles.size(); )
+        {
+            std::size_t end = std::min( m_Tiles.find( '|', begin ), m_Tiles.size() );
+            if( m_TileLines.size() <= tileLine )
+                m_TileLines.resize( tileLine+1 );
+            m_TileLines[tileLine].assign( m_Tiles, begin, end-begin );
+            ++tileLine;
+            begin = ( end == m_Tiles.size() ? end : end+1 );
+        }
+        return;
+    }
+
+    // determine if it is a key-value pair
+    StringView key;
+    StringView value;
+    if( this->getKeyValuePair( line, key, value ) )
+    {
+
+        // special case for collection name, which was already read if
+        // no collection is passed
+        if( key.equals("Collection") )
+        {
+            if( collection )
+                collection->setName( value.str() );
+            return;
+        }
+
+        // special case for snapshots
+        if( key.equals("Snapshot") )
+        {
+            lvl.importUndoData( value.str() );
+            return;
+        }
+
+        // add meta data to level
+        lvl.addMetaData( key.str(), value.str() );
+        return;
+    }
+
+    // add data as comment data
+    if( levelDataReadForFirstTime )
+        lvl.addLevelNote( line.str() );
+    else
+        lvl.addHeaderData( line.str() );
+}
+
+// --------------------------------------------------------------
+void CollectionParserSOK::insertTileLines( Uint32& tileLine, Level& lvl )
+{
+    if( !tileLine ) return;
+    lvl.insertTileLines( 0, m_TileLines, tileLine );
+    tileLine = 0;
+}
+
+// --------------------------------------------------------------
+void CollectionParserSOK::_parse( const MappedFile& file, Collection& collection )
+{
+#ifdef _DEBUG
+    std::cout << "parsing SOK" << std::endl;
 #endif
 
+    // with lazy loading or multiple parser threads, only the name and
+    // location of each level is recorded. The levels are parsed by
+    // _parseLevel once they are needed.
+    bool scanOnly = ( collection.isLazyLoadingEnabled() || collection.getNumParserThreads() != 1 );
+    LevelSource source;
+    source.begin = 0;
+
     // the first level is a requirement
-    Level* lvl = collection.addLevel();
-
-    // run length encoding
-    RLE rle;
-
+    Level* lvl = collection.addLevel();
+
     // parser temporaries
     Uint32 tileLine = 0;
     bool lastLineWasBlank = true;
     bool isLevelData = false;
     bool lastLineWasLevelData = false;
     bool levelDataReadForFirstTime = false;
-    std::string inBuf("");
-    std::string oldInBuf("");
+    LineReader reader( file.data(), file.size() );
+    std::size_t lineBegin = 0;
+    StringView inBuf;
+    StringView oldInBuf;
     std::string levelName("");
-    std::string tempLevelName("");
-
+    std::string tempLevelName("");
+
+    // lines containing tabs are copied so the tabs can be removed. Two
+    // buffers take turns, because the old line has to stay valid.
+    std::string tablessBuf[2];
+    std::size_t tablessIndex = 0;
+
     // parse file
-    while( !file.eof() )
+    while( !reader.eof() )
     {
 
         // read line from file and filter out any blank lines
@@ -107,20 +192,23 @@ void CollectionParserSOK::_parse( std::ifstream& file, Collection& collection )
         // in an old buffer so the title of the level can be determined later on
         lastLineWasBlank = false;
         oldInBuf = inBuf;
-        while(!file.eof())
+        while( !reader.eof() )
         {
-            std::getline( file, inBuf );
+            lineBegin = reader.getOffset();
+            reader.getLine( inBuf );
             if( inBuf.size() > 1 )
                 break;
             lastLineWasBlank = true;
         }
 
         // remove tabs
-        inBuf.erase(std::remove(inBuf.begin(), inBuf.end(), '\t'), inBuf.end());
+        this->removeTabs( inBuf, tablessBuf[tablessIndex] );
+        if( inBuf.data() == tablessBuf[tablessIndex].data() )
+            tablessIndex ^= 1;
 
         // so checks are only performed once
         lastLineWasLevelData = isLevelData;
-        isLevelData = Utils::isTileData( inBuf );
+        isLevelData = ( Utils::isTileData( inBuf ) || Utils::isTileLineRLE( inBuf ) );
 
         // requirements for a level title are:
         // - the last non-blank line before a puzzle, saved game, or solution
@@ -128,14 +216,15 @@ void CollectionParserSOK::_parse( std::ifstream& file, Collection& collection )
         // - must not be a comment
         // copying the last line as the level title before getting a new line
         // from the file to meet these requirements
+        // (lastLineWasLevelData already tells if the old line is tile data)
 
-        if( lastLineWasBlank && oldInBuf.find("::") == std::string::npos && isLevelData && !Utils::isTileData( oldInBuf ) )
+        if( lastLineWasBlank && oldInBuf.find("::") == std::string::npos && isLevelData && !lastLineWasLevelData )
         {
-            std::string key("");
-            std::string value("");
+            StringView key;
+            StringView value;
             if( !this->getKeyValuePair(oldInBuf, key, value) )
             {
-                tempLevelName = oldInBuf;
+                tempLevelName = oldInBuf.str();
                 if( levelName.size() == 0 && !levelDataReadForFirstTime )
                     levelName = tempLevelName;
             }
@@ -145,86 +234,254 @@ void CollectionParserSOK::_parse( std::ifstream& file, Collection& collection )
         // this only works if level data has been read at least once
         if( levelDataReadForFirstTime && (!lastLineWasLevelData || lastLineWasBlank) && isLevelData )
         {
-            if( levelName.size() != 0 )
+
+            // level name was added in the last pass, remove it again
+            if( scanOnly )
             {
-                lvl->removeHeaderData( levelName ); // level name was added in the last pass, remove it again
-                lvl->removeLevelNote( levelName );
-            }
-            if( tempLevelName.size() != 0 )
+                if( levelName.size() != 0 ) source.titles.push_back( levelName );
+                if( tempLevelName.size() != 0 ) source.titles.push_back( tempLevelName );
+            }else
             {
-                lvl->removeHeaderData( tempLevelName );
-                lvl->removeLevelNote( tempLevelName );
+                if( levelName.size() != 0 )
+                {
+                    lvl->removeHeaderData( levelName );
+                    lvl->removeLevelNote( levelName );
+                }
+                if( tempLevelName.size() != 0 )
+                {
+                    lvl->removeHeaderData( tempLevelName );
+                    lvl->removeLevelNote( tempLevelName );
+                }
             }
 
             // finalise the level name
             collection.generateLevelName( levelName );
             lvl->setLevelName( levelName );
 
+            // the level ends where the line of the next level begins
+            if( scanOnly )
+            {
+                source.end = lineBegin;
+                collection.deferLevel( lvl, source );
+                source.begin = lineBegin;
+                source.titles.clear();
+            }
+
             // TODO reverse Y order of level array (see issue #16)
+            this->insertTileLines( tileLine, *lvl );
 
             // generate new level
             lvl = collection.addLevel();
             if( levelName.compare( tempLevelName ) == 0 ) tempLevelName = "";
             levelName = tempLevelName;
-            tileLine = 0;
         }
         if( isLevelData )
             levelDataReadForFirstTime = true;
 
         // process input
-        for(;;){
+        if( !scanOnly )
+        {
+            this->processLine( inBuf, isLevelData, levelDataReadForFirstTime, tileLine, *lvl, &collection );
+            continue;
+        }
+
+        // the collection name is needed before any level is parsed
+        StringView key;
+        StringView value;
+        if( !isLevelData && this->getKeyValuePair( inBuf, key, value ) && key.equals("Collection") )
+            collection.setName( value.str() );
+    }
+
+    // give the still open level its tiles and name
+    this->insertTileLines( tileLine, *lvl );
+    collection.generateLevelName( levelName );
+    lvl->setLevelName( levelName );
+    if( scanOnly )
+    {
+        source.end = file.size();
+        collection.deferLevel( lvl, source );
+    }
+
+#ifdef _DEBUG
+    std::cout << "parsing SOK successful" << std::endl;
+#endif
+}
+
+// --------------------------------------------------------------
+void CollectionParserSOK::_parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl )
+{
+
+    // a level cut off by the next level ends right before that level's
+    // first line. Stop there instead of reading the empty rest as a line.
+    bool isCut = ( source.end != file.size() );
+    LineReader reader( file.data() + source.begin, source.end - source.begin );
+    std::size_t size = source.end - source.begin;
+
+    // only the first level of a file starts with header data
+    Uint32 tileLine = 0;
+    bool levelDataReadForFirstTime = ( source.begin != 0 );
+    bool isLevelData;
+    StringView inBuf;
+    std::string tablessBuf;
 
-            // determine if if is level data
-            if( isLevelData )
+    while( !reader.eof() && !(isCut && reader.getOffset() == size) )
+    {
+
+        // skip blank lines
+        bool found = false;
+        while( !reader.eof() && !(isCut && reader.getOffset() == size) )
+        {
+            reader.getLine( inBuf );
+            if( inBuf.size() > 1 )
             {
-                rle.decompress( inBuf );
-                this->convertTilesToConventional( inBuf );
-                lvl->insertTileLine( tileLine, inBuf );
-                ++tileLine;
+                found = true;
                 break;
             }
+        }
+        if( !found && !reader.eof() )
+            break;
 
-            // determine if it is a key-value pair
-            std::string key("");
-            std::string value("");
-            if( this->getKeyValuePair( inBuf, key, value ) )
-            {
+        this->removeTabs( inBuf, tablessBuf );
+        isLevelData = ( Utils::isTileData( inBuf ) || Utils::isTileLineRLE( inBuf ) );
+        if( isLevelData )
+            levelDataReadForFirstTime = true;
+        this->processLine( inBuf, isLevelData, levelDataReadForFirstTime, tileLine, lvl, 0 );
+    }
+    this->insertTileLines( tileLine, lvl );
 
-                // special case for collection name
-                if( key.compare("Collection") == 0 )
-                {
-                    collection.setName( value );
-                    break;
-                }
+    // level titles were read as notes or header data
+    for( std::vector<std::string>::const_iterator it = source.titles.begin(); it != source.titles.end(); ++it )
+    {
+        lvl.removeHeaderData( *it );
+        lvl.removeLevelNote( *it );
+    }
+}
 
-                // special case for snapshots
-                if( key.compare("Snapshot") == 0 )
-                {
-                    lvl->importUndoData( value );
-                    break;
-                }
+// --------------------------------------------------------------
+void CollectionParserSOK::_parse( const MappedFile& file, CollectionParserListener& listener )
+{
+
+    // parser temporaries
+    bool lastLineWasBlank = true;
+    bool isLevelData = false;
+    bool lastLineWasLevelData = false;
+    bool isInLevel = false;
+    LineReader reader( file.data(), file.size() );
+    StringView inBuf;
+    std::string levelName("");
+    std::string buffer("");
+
+    // a note is held back for one line, because it turns out to be the
+    // title of the next level if tile data follows after a blank line
+    StringView heldNote;
+    bool isNoteHeld = false;
+
+    // lines containing tabs are copied so the tabs can be removed. Two
+    // buffers take turns, because the held note has to stay valid.
+    std::string tablessBuf[2];
+    std::size_t tablessIndex = 0;
+
+    while( !reader.eof() )
+    {
 
-                // add meta data to level
-                lvl->addMetaData( key, value );
+        // read line from file and filter out any blank lines
+        lastLineWasBlank = false;
+        while( !reader.eof() )
+        {
+            reader.getLine( inBuf );
+            if( inBuf.size() > 1 )
                 break;
+            lastLineWasBlank = true;
+        }
+        if( inBuf.size() <= 1 )
+            break;
+
+        // remove tabs
+        this->removeTabs( inBuf, tablessBuf[tablessIndex] );
+        if( inBuf.data() == tablessBuf[tablessIndex].data() )
+            tablessIndex ^= 1;
+
+        lastLineWasLevelData = isLevelData;
+        isLevelData = ( Utils::isTileData( inBuf ) || Utils::isTileLineRLE( inBuf ) );
+
+        // the held note is either the title of a new level or a note
+        if( isNoteHeld )
+        {
+            buffer = heldNote.str();
+            if( lastLineWasBlank && isLevelData )
+                levelName = buffer;
+            else if( isInLevel )
+                listener.onNote( buffer );
+            else
+                listener.onHeaderData( buffer );
+            isNoteHeld = false;
+        }
+
+        // tile data after something else or after a blank line begins a new level
+        if( isLevelData && (!lastLineWasLevelData || lastLineWasBlank) )
+        {
+            if( isInLevel )
+                listener.onLevelEnd();
+            listener.onLevelBegin( levelName );
+            isInLevel = true;
+            levelName = "";
+        }
+
+        // tile data, compressed levels have all rows on one line
+        if( isLevelData )
+        {
+            m_Tiles.clear();
+            m_RLE.decompress( inBuf.data(), inBuf.size(), m_Tiles );
+            this->convertTilesToConventional( m_Tiles );
+            for( std::size_t begin = 0; begin != m_Tiles.size(); )
+            {
+                std::size_t end = std::min( m_Tiles.find( '|', begin ), m_Tiles.size() );
+                buffer.assign( m_Tiles, begin, end-begin );
+                listener.onTileRow( buffer );
+                begin = ( end == m_Tiles.size() ? end : end+1 );
             }
+            continue;
+        }
 
-            // add data as comment data
-            if( levelDataReadForFirstTime )
-                lvl->addLevelNote( inBuf );
+        // key-value pairs
+        StringView key;
+        StringView value;
+        if( this->getKeyValuePair( inBuf, key, value ) )
+        {
+            if( key.equals("Collection") )
+                listener.onCollectionName( value.str() );
+            else if( key.equals("Snapshot") )
+                listener.onSnapshot( value.str() );
             else
-                lvl->addHeaderData( inBuf );
-            break;
+                listener.onMetaData( key.str(), value.str() );
+            continue;
+        }
+
+        // comments can't be titles
+        if( inBuf.find("::") == std::string::npos )
+        {
+            heldNote = inBuf;
+            isNoteHeld = true;
+            continue;
         }
+        buffer = inBuf.str();
+        if( isInLevel )
+            listener.onNote( buffer );
+        else
+            listener.onHeaderData( buffer );
     }
 
-    // give the still open level its name
-    collection.generateLevelName( levelName );
-    lvl->setLevelName( levelName );
-
-#ifdef _DEBUG
-    std::cout << "parsing SOK successful" << std::endl;
-#endif
+    // flush whatever is still open
+    if( isNoteHeld )
+    {
+        buffer = heldNote.str();
+        if( isInLevel )
+            listener.onNote( buffer );
+        else
+            listener.onHeaderData( buffer );
+    }
+    if( isInLevel )
+        listener.onLevelEnd();
 }
 
 // --------------------------------------------------------------
@@ -265,9 +522,13 @@ void CollectionParserSOK::_save( std::ofstream& file, const Collection& collecti
         // add meta data below tile data
         (*it)->streamAllMetaData( file );
 
-        // save snapshot
+        // save snapshot with optional RLE compression
         if( (*it)->undoDataExists() || (*it)->redoDataExists() )
-            file << "Snapshot: " << (*it)->exportUndoData() << std::endl;
+        {
+            std::string snapshot = (*it)->exportUndoData();
+            if( m_EnableRLE ) rle.multiPassCompress( snapshot );
+            file << "Snapshot: " << snapshot << std::endl;
+        }
 
     }
 }
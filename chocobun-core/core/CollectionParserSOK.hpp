@@ -26,6 +26,11 @@
 // include files
 
 #include <core/CollectionParserBase.hpp>
+#include <core/StringView.hpp>
+#include <core/RLE.hpp>
+
+#include <string>
+#include <vector>
 
 namespace Chocobun {
 
@@ -50,13 +55,13 @@ public:
     ~CollectionParserSOK( void );
 
     /*!
-     * @brief Enables RLE compression for tile data when exporting
+     * @brief Enables RLE compression for tile data and snapshots when exporting
      * @note Default is <b>disabled</b>
      */
     void enableCompression( void );
 
     /*!
-     * @brief Disables RLE compression for tile data when exporting
+     * @brief Disables RLE compression for tile data and snapshots when exporting
      * @note Default is <b>disabled</b>
      */
     void disableCompression( void );
@@ -68,12 +73,67 @@ private:
      *
      * See http://sokobano.de/wiki/index.php?title=Sok_format for more information
      *
-     * @param file An open file object to read from
+     * Lines are read as views into the mapped file. Only data that is kept
+     * in the collection is copied into strings.
+     *
+     * @param file An open memory mapped file to read from
      * @param levelMap An std::vector of levels to write to
      * @return Returns the name of the collection (if any), otherwise the string
      * is empty
      */
-    void _parse( std::ifstream& file, Collection& collection );
+    void _parse( const MappedFile& file, Collection& collection );
+
+    /*!
+     * @brief Parses a single level which was skipped by _parse
+     *
+     * @param file The memory mapped file the level was found in
+     * @param source The location of the level in the file
+     * @param lvl The level to write the tile data, notes and snapshot to
+     */
+    void _parseLevel( const MappedFile& file, const LevelSource& source, Level& lvl );
+
+    /*!
+     * @brief Streams a .SOK file to a listener
+     *
+     * Levels are found with the same rules as when parsing into a
+     * collection. Lines are passed on as they are read, except for the last
+     * note before a level, which is held back until it is clear whether it
+     * is the title of the level.
+     *
+     * @param file An open memory mapped file to read from
+     * @param listener The listener to send the contents to
+     */
+    void _parse( const MappedFile& file, CollectionParserListener& listener );
+
+    /*!
+     * @brief Adds a line of tile data, meta data or notes to a level
+     *
+     * @param line The line to add
+     * @param isLevelData Whether the line is tile data or not
+     * @param levelDataReadForFirstTime If false, notes are added as header data
+     * @param tileLine The number of lines of tile data collected for the
+     * level so far, incremented for each line of tile data
+     * @param lvl The level to add to
+     * @param collection The collection to set the name of, or 0 to ignore the
+     * collection name
+     */
+    void processLine( const StringView& line, const bool& isLevelData, const bool& levelDataReadForFirstTime, Uint32& tileLine, Level& lvl, Collection* collection );
+
+    /*!
+     * @brief Inserts the collected lines of tile data into a level
+     *
+     * @param tileLine The number of lines collected, reset to 0 afterwards
+     * @param lvl The level to insert the lines into
+     */
+    void insertTileLines( Uint32& tileLine, Level& lvl );
+
+    /*!
+     * @brief Removes tabs from a line
+     *
+     * If the line contains tabs, it is copied into the buffer without them
+     * and the view is pointed at the buffer.
+     */
+    void removeTabs( StringView& line, std::string& buffer );
 
     /*!
      * @brief Universal .SOK format exporter
@@ -89,13 +149,16 @@ private:
      * @brief Extracts key value pairs and returns true or false if successful
      *
      * @param str The string to search for key-value pairs
-     * @param key Output string where the key is written to
-     * @param value Output string where the value is written to
+     * @param key Output view of the key, referring to the same characters as str
+     * @param value Output view of the value, referring to the same characters as str
      * @return True if a key-value pair was found, false if otherwise
      */
-    bool getKeyValuePair( const std::string& str, std::string& key, std::string& value );
+    bool getKeyValuePair( const StringView& str, StringView& key, StringView& value );
 
     bool m_EnableRLE;
+    RLE m_RLE;
+    std::string m_Tiles;
+    std::vector<std::string> m_TileLines;
 
 };
 
@@ -36,6 +36,20 @@
 #       error This operating system is not supported
 #   endif
 
+// --------------------------------------------------------------
+// Identify available SIMD instruction sets
+// --------------------------------------------------------------
+
+    // define CHOCOBUN_CORE_NO_SIMD to only use portable code
+#   if !defined(CHOCOBUN_CORE_NO_SIMD)
+#       if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#           define CHOCOBUN_CORE_SIMD_SSE2
+#       endif
+#       if defined(__AVX2__)
+#           define CHOCOBUN_CORE_SIMD_AVX2
+#       endif
+#   endif
+
 // --------------------------------------------------------------
 // define import/export macros
 // --------------------------------------------------------------
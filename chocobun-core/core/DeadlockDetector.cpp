@@ -0,0 +1,307 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// DeadlockDetector.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/DeadlockDetector.hpp>
+#include <core/Level.hpp>
+#include <core/Exception.hpp>
+
+#include <algorithm> // std::find
+#include <utility> // std::swap
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// constants
+
+namespace {
+
+const std::size_t NO_BOX = static_cast<std::size_t>(-1);
+
+} // anonymous namespace
+
+// --------------------------------------------------------------
+DeadlockDetector::DeadlockDetector( void ) :
+    m_NumGoals( 0 ),
+    m_GoalWords( 0 ),
+    m_IsPrepared( false )
+{
+}
+
+// --------------------------------------------------------------
+DeadlockDetector::~DeadlockDetector( void )
+{
+}
+
+// --------------------------------------------------------------
+void DeadlockDetector::swap( DeadlockDetector& that ) noexcept
+{
+    m_WallBoard.swap( that.m_WallBoard );
+    m_GoalBoard.swap( that.m_GoalBoard );
+    m_DeadSquareBoard.swap( that.m_DeadSquareBoard );
+    std::swap( m_NumGoals, that.m_NumGoals );
+    std::swap( m_GoalWords, that.m_GoalWords );
+    m_ReachableGoals.swap( that.m_ReachableGoals );
+    std::swap( m_IsPrepared, that.m_IsPrepared );
+}
+
+// --------------------------------------------------------------
+void DeadlockDetector::prepare( const Level& level )
+{
+    if( !level.isValid() || level.getWallBoard().size() == 0 )
+        throw Exception( "[DeadlockDetector::prepare] Error: level must be validated and reset first" );
+
+    m_WallBoard = level.getWallBoard();
+    m_GoalBoard = level.getGoalBoard();
+    m_DeadSquareBoard = level.getDeadSquareBoard();
+    m_NumGoals = m_GoalBoard.count();
+    m_GoalWords = (m_NumGoals + 63) >> 6;
+    m_ReachableGoals.assign( m_WallBoard.size() * m_GoalWords, 0 );
+
+    // the player can never get to squares outside of its region
+    Bitboard region( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    Bitboard passable( m_WallBoard );
+    passable.invert();
+    region.set( m_WallBoard.index( level.getPlayerX(), level.getPlayerY() ) );
+    region.floodFill( passable );
+
+    // pull a box away from each goal separately to find out which goals a
+    // box on any square could be pushed to
+    std::size_t delta[4] = { static_cast<std::size_t>(0)-m_WallBoard.stride(), m_WallBoard.stride(),
+                             static_cast<std::size_t>(0)-1, 1 };
+    std::vector<std::size_t> queue;
+    Bitboard reached( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    std::size_t goal = 0;
+    for( std::size_t i = m_GoalBoard.findFirst(); i != Bitboard::npos; i = m_GoalBoard.findNext(i), ++goal )
+    {
+        reached.clear();
+        reached.set( i );
+        queue.assign( 1, i );
+        for( std::size_t head = 0; head != queue.size(); ++head )
+        {
+            m_ReachableGoals[queue[head]*m_GoalWords + (goal >> 6)] |= Uint64(1) << (goal & 63);
+            for( std::size_t direction = 0; direction != 4; ++direction )
+            {
+                std::size_t from = queue[head] + delta[direction];
+                std::size_t pusher = from + delta[direction];
+                if( !region.test(from) || !region.test(pusher) || reached.test(from) ) continue;
+                reached.set( from );
+                queue.push_back( from );
+            }
+        }
+    }
+
+    m_IsPrepared = true;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isPrepared( void ) const
+{
+    return m_IsPrepared;
+}
+
+// --------------------------------------------------------------
+DeadlockDetector::Type DeadlockDetector::check( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const
+{
+    if( m_DeadSquareBoard.test(to) ) return DEADLOCK_DEAD_SQUARE;
+    if( this->isFrozenDeadlock( boxes, to ) ) return DEADLOCK_FROZEN;
+    if( this->isBipartiteDeadlock( boxes, from, to ) ) return DEADLOCK_BIPARTITE;
+    if( this->isCorralDeadlock( boxes, from, to ) ) return DEADLOCK_CORRAL;
+    return DEADLOCK_NONE;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isFrozenDeadlock( const Bitboard& boxes, const std::size_t& to ) const
+{
+
+    // only the pushed box can have become frozen. If it did, so did every
+    // box that helps blocking it.
+    std::vector<std::size_t> stack;
+    bool offGoal = false;
+    return this->isFrozen( boxes, to, stack, offGoal ) && offGoal;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isFrozen( const Bitboard& boxes, const std::size_t& index,
+                                 std::vector<std::size_t>& stack, bool& offGoal ) const
+{
+    bool blockersOffGoal = false;
+    stack.push_back( index );
+    bool frozen = this->isAxisBlocked( boxes, index, 1, stack, blockersOffGoal ) &&
+                  this->isAxisBlocked( boxes, index, m_WallBoard.stride(), stack, blockersOffGoal );
+    stack.pop_back();
+    if( frozen && ( blockersOffGoal || !m_GoalBoard.test(index) ) )
+        offGoal = true;
+    return frozen;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isAxisBlocked( const Bitboard& boxes, const std::size_t& index, const std::size_t& delta,
+                                      std::vector<std::size_t>& stack, bool& offGoal ) const
+{
+    std::size_t before = index - delta, after = index + delta;
+
+    // walls and boxes which are already being checked block for good
+    if( m_WallBoard.test(before) || m_WallBoard.test(after) ) return true;
+    if( std::find( stack.begin(), stack.end(), before ) != stack.end() ) return true;
+    if( std::find( stack.begin(), stack.end(), after ) != stack.end() ) return true;
+
+    // moving along this axis would put the box on a dead square either way
+    if( m_DeadSquareBoard.test(before) && m_DeadSquareBoard.test(after) ) return true;
+
+    // neighbouring boxes block if they can never move either
+    if( boxes.test(before) && this->isFrozen( boxes, before, stack, offGoal ) ) return true;
+    if( boxes.test(after) && this->isFrozen( boxes, after, stack, offGoal ) ) return true;
+    return false;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isBipartiteDeadlock( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const
+{
+
+    // the assignment before the push is still valid if the box can reach at
+    // least the goals it could reach before
+    const Uint64* before = this->getReachableGoals( from );
+    const Uint64* after = this->getReachableGoals( to );
+    bool lostGoal = false;
+    for( std::size_t i = 0; i != m_GoalWords; ++i )
+        if( before[i] & ~after[i] ) lostGoal = true;
+    if( !lostGoal ) return false;
+
+    return this->isBipartiteDeadlock( boxes );
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isBipartiteDeadlock( const Bitboard& boxes ) const
+{
+    std::vector<std::size_t> boxList;
+    for( std::size_t i = boxes.findFirst(); i != Bitboard::npos; i = boxes.findNext(i) )
+        boxList.push_back( i );
+    if( boxList.size() > m_NumGoals ) return true;
+
+    std::vector<std::size_t> goalOwner( m_NumGoals, NO_BOX );
+    std::vector<bool> visited;
+    for( std::size_t box = 0; box != boxList.size(); ++box )
+    {
+        visited.assign( m_NumGoals, false );
+        if( !this->assignGoal( box, boxList, goalOwner, visited ) )
+            return true;
+    }
+    return false;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::assignGoal( const std::size_t& box, const std::vector<std::size_t>& boxList,
+                                   std::vector<std::size_t>& goalOwner, std::vector<bool>& visited ) const
+{
+    const Uint64* goals = this->getReachableGoals( boxList[box] );
+    for( std::size_t goal = 0; goal != m_NumGoals; ++goal )
+    {
+        if( !( (goals[goal >> 6] >> (goal & 63)) & 1 ) || visited[goal] ) continue;
+        visited[goal] = true;
+
+        // take the goal if it's free or its owner can move on to another one
+        if( goalOwner[goal] == NO_BOX || this->assignGoal( goalOwner[goal], boxList, goalOwner, visited ) )
+        {
+            goalOwner[goal] = box;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --------------------------------------------------------------
+bool DeadlockDetector::isCorralDeadlock( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const
+{
+
+    // squares the player can walk to after the push
+    Bitboard passable( m_WallBoard );
+    passable |= boxes;
+    passable.invert();
+    Bitboard reachable( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    reachable.set( from );
+    reachable.floodFill( passable );
+
+    std::size_t delta[4] = { static_cast<std::size_t>(0)-m_WallBoard.stride(), m_WallBoard.stride(),
+                             static_cast<std::size_t>(0)-1, 1 };
+    Bitboard corral( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    Bitboard fence( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    Bitboard checked( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    std::size_t numBoxes = boxes.count();
+
+    // only areas next to the pushed box can have been closed off by the push
+    for( std::size_t side = 0; side != 4; ++side )
+    {
+        std::size_t seed = to + delta[side];
+        if( !passable.test(seed) || reachable.test(seed) || checked.test(seed) ) continue;
+        corral.clear();
+        corral.set( seed );
+        corral.floodFill( passable );
+        checked |= corral;
+
+        // boxes bordering the area
+        fence.clear();
+        bool emptyGoal = false;
+        for( std::size_t i = corral.findFirst(); i != Bitboard::npos; i = corral.findNext(i) )
+        {
+            if( m_GoalBoard.test(i) ) emptyGoal = true;
+            for( std::size_t direction = 0; direction != 4; ++direction )
+                if( boxes.test( i + delta[direction] ) )
+                    fence.set( i + delta[direction] );
+        }
+
+        // the area stays closed as long as no fence box can be the first to
+        // move. A push is impossible before that if the player would have to
+        // stand on a wall, inside the area or on another fence box, or if the
+        // box would end up in a wall, on a dead square or on a fence box.
+        bool sealed = true, offGoal = false;
+        for( std::size_t i = fence.findFirst(); sealed && i != Bitboard::npos; i = fence.findNext(i) )
+        {
+            if( !m_GoalBoard.test(i) ) offGoal = true;
+            for( std::size_t direction = 0; direction != 4; ++direction )
+            {
+                std::size_t pusher = i - delta[direction], target = i + delta[direction];
+                if( m_WallBoard.test(pusher) || corral.test(pusher) || fence.test(pusher) ) continue;
+                if( m_WallBoard.test(target) || m_DeadSquareBoard.test(target) || fence.test(target) ) continue;
+                sealed = false;
+                break;
+            }
+        }
+        if( !sealed ) continue;
+
+        // empty goals inside only matter if there are no spare goals
+        if( offGoal || ( emptyGoal && numBoxes == m_NumGoals ) )
+            return true;
+    }
+    return false;
+}
+
+// --------------------------------------------------------------
+const Uint64* DeadlockDetector::getReachableGoals( const std::size_t& index ) const
+{
+    static const Uint64 none = 0;
+    if( !m_GoalWords ) return &none;
+    return &m_ReachableGoals[index * m_GoalWords];
+}
+
+} // namespace Chocobun
@@ -0,0 +1,175 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// DeadlockDetector.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_DEADLOCK_DETECTOR_HPP__
+#define __CHOCOBUN_CORE_DEADLOCK_DETECTOR_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+#include <core/Bitboard.hpp>
+
+#include <vector>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// forward declarations
+
+class Level;
+
+/*!
+ * @brief Detects positions from which a level can no longer be solved
+ *
+ * The detector is prepared once per level, after which it checks the
+ * consequences of single pushes. All checks only look at the area around
+ * the pushed box, and never report a position that can still be solved.
+ *
+ * Positions are described by bitboards using the layout of
+ * Level::getBoxBoard. Checking is thread safe once the detector is
+ * prepared.
+ */
+class DeadlockDetector
+{
+public:
+
+    /*!
+     * @brief Kinds of deadlocks
+     */
+    enum Type
+    {
+        DEADLOCK_NONE,          //!< The position may still be solvable
+        DEADLOCK_DEAD_SQUARE,   //!< A box was pushed onto a dead square
+        DEADLOCK_FROZEN,        //!< Boxes block each other and at least one of them isn't on a goal
+        DEADLOCK_BIPARTITE,     //!< Not every box can be assigned a goal of its own
+        DEADLOCK_CORRAL         //!< Boxes seal off an area and can never be pushed again
+    };
+
+    /*!
+     * @brief Constructor
+     */
+    DeadlockDetector( void );
+
+    /*!
+     * @brief Destructor
+     */
+    ~DeadlockDetector( void );
+
+    /*!
+     * @brief Exchanges the precalculated data of two detectors without copying it
+     */
+    void swap( DeadlockDetector& that ) noexcept;
+
+    /*!
+     * @brief Precalculates everything that only depends on walls and goals
+     * @exception Chocobun::Exception if the level hasn't been validated and reset
+     */
+    void prepare( const Level& level );
+
+    /*!
+     * @brief Checks if the detector was prepared
+     */
+    bool isPrepared( void ) const;
+
+    /*!
+     * @brief Runs all checks on a push
+     * @param boxes The boxes after the push
+     * @param from The bit index the box was pushed from, which is where the player is now
+     * @param to The bit index the box was pushed to
+     * @return The first deadlock found, or DEADLOCK_NONE
+     */
+    Type check( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const;
+
+    /*!
+     * @brief Checks if the pushed box and the boxes around it can never move again
+     * @param boxes The boxes after the push
+     * @param to The bit index the box was pushed to
+     */
+    bool isFrozenDeadlock( const Bitboard& boxes, const std::size_t& to ) const;
+
+    /*!
+     * @brief Checks if there are boxes which can't be assigned a goal of their own
+     * The full assignment is only recalculated if the pushed box lost access
+     * to a goal, otherwise the position is assumed to have been fine before.
+     * @param boxes The boxes after the push
+     * @param from The bit index the box was pushed from
+     * @param to The bit index the box was pushed to
+     */
+    bool isBipartiteDeadlock( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const;
+
+    /*!
+     * @brief Checks if there are boxes which can't be assigned a goal of their own
+     * @param boxes The boxes of the position
+     */
+    bool isBipartiteDeadlock( const Bitboard& boxes ) const;
+
+    /*!
+     * @brief Checks if the pushed box sealed off an area the player can't get into
+     * An area is sealed if none of the boxes around it can be the first one to
+     * move. The position is a deadlock if any of those boxes isn't on a goal.
+     * @param boxes The boxes after the push
+     * @param from The bit index the box was pushed from, which is where the player is now
+     * @param to The bit index the box was pushed to
+     */
+    bool isCorralDeadlock( const Bitboard& boxes, const std::size_t& from, const std::size_t& to ) const;
+
+private:
+
+    /*!
+     * @brief Checks if a box can never move again
+     * Boxes on the stack are treated as walls.
+     * @param offGoal Set to true if the box or one of the boxes blocking it
+     * isn't on a goal. Only written if the box is frozen.
+     */
+    bool isFrozen( const Bitboard& boxes, const std::size_t& index,
+                   std::vector<std::size_t>& stack, bool& offGoal ) const;
+
+    /*!
+     * @brief Checks if a box can't move along one axis
+     */
+    bool isAxisBlocked( const Bitboard& boxes, const std::size_t& index, const std::size_t& delta,
+                        std::vector<std::size_t>& stack, bool& offGoal ) const;
+
+    /*!
+     * @brief Tries to assign a goal to a box, reassigning other boxes if required
+     */
+    bool assignGoal( const std::size_t& box, const std::vector<std::size_t>& boxList,
+                     std::vector<std::size_t>& goalOwner, std::vector<bool>& visited ) const;
+
+    /*!
+     * @brief Gets the set of goals a box on a square could be pushed to
+     */
+    const Uint64* getReachableGoals( const std::size_t& index ) const;
+
+    Bitboard                    m_WallBoard;
+    Bitboard                    m_GoalBoard;
+    Bitboard                    m_DeadSquareBoard;
+    std::size_t                 m_NumGoals;
+    std::size_t                 m_GoalWords;
+    std::vector<Uint64>         m_ReachableGoals;   // one set of goals per square
+    bool                        m_IsPrepared;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_DEADLOCK_DETECTOR_HPP__
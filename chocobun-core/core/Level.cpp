@@ -28,56 +28,116 @@
 #include <core/LevelListener.hpp>
 #include <core/Array2D.hpp>
 #include <core/Exception.hpp>
+#include <core/RLE.hpp>
 
 #include <sstream>
+#include <utility> // std::swap
+#include <algorithm> // std::max, std::copy
 
 namespace Chocobun {
 
+// --------------------------------------------------------------
+// helpers
+
+namespace {
+
+// --------------------------------------------------------------
+// Zobrist key of a square. Keys are derived from the bit index with the
+// splitmix64 finaliser, so no table needs to be stored and equal states
+// of equally sized levels always hash to the same value.
+Uint64 zobristKey( const std::size_t& index, const Uint64& kind )
+{
+    Uint64 key = ( static_cast<Uint64>(index) << 1 | kind ) * 0x9E3779B97F4A7C15ULL;
+    key = ( key ^ (key >> 30) ) * 0xBF58476D1CE4E5B9ULL;
+    key = ( key ^ (key >> 27) ) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
+
+const Uint64 ZOBRIST_BOX    = 0;
+const Uint64 ZOBRIST_PLAYER = 1;
+
+} // anonymous namespace
+
 // --------------------------------------------------------------
 Level::Level( void ) :
-    m_LevelArray( 0 ),
-    m_InitialLevelArray( 0 ),
+    m_Text( getEmptyText() ),
+    m_LevelArray( getEmptyLevelArray() ),
+    m_InitialLevelArray( getEmptyLevelArray() ),
+    m_OwnsText( false ),
+    m_OwnsLevelArray( false ),
+    m_OwnsInitialLevelArray( false ),
     m_PlayerX( 0 ),
     m_PlayerY( 0 ),
-    m_UndoDataPos( 0 ),
+    m_HasUnrecordedMoves( false ),
+    m_BoxHash( 0 ),
+    m_NormalisedPlayer( 0 ),
+    m_IsPlayerRegionDirty( true ),
+    m_RefuseDeadlyPushes( false ),
+    m_DetectDeadlocks( false ),
     m_IsLevelValid( false )
 {
-    m_LevelArray = new LevelArray_t(' ');
-    m_InitialLevelArray = new LevelArray_t(' ');
 }
 
 // --------------------------------------------------------------
 Level::Level( const Level& that ) :
-    m_LevelArray( 0 ),
-    m_InitialLevelArray( 0 ),
+    m_Text( that.m_Text ),
+    m_LevelArray( that.m_LevelArray ),
+    m_InitialLevelArray( that.m_InitialLevelArray ),
+    m_OwnsText( false ),
+    m_OwnsLevelArray( false ),
+    m_OwnsInitialLevelArray( false ),
     m_PlayerX( 0 ),
     m_PlayerY( 0 ),
-    m_UndoDataPos( 0 ),
+    m_HasUnrecordedMoves( false ),
+    m_BoxHash( 0 ),
+    m_NormalisedPlayer( 0 ),
+    m_IsPlayerRegionDirty( true ),
+    m_RefuseDeadlyPushes( false ),
+    m_DetectDeadlocks( false ),
     m_IsLevelValid( false )
 {
     *this = that;
 }
 
+// --------------------------------------------------------------
+Level::Level( Level&& that ) noexcept :
+    m_Text( getEmptyText() ),
+    m_LevelArray( getEmptyLevelArray() ),
+    m_InitialLevelArray( getEmptyLevelArray() ),
+    m_OwnsText( false ),
+    m_OwnsLevelArray( false ),
+    m_OwnsInitialLevelArray( false ),
+    m_PlayerX( 0 ),
+    m_PlayerY( 0 ),
+    m_HasUnrecordedMoves( false ),
+    m_BoxHash( 0 ),
+    m_NormalisedPlayer( 0 ),
+    m_IsPlayerRegionDirty( true ),
+    m_RefuseDeadlyPushes( false ),
+    m_DetectDeadlocks( false ),
+    m_IsLevelValid( false )
+{
+    this->swap( that );
+}
+
 // --------------------------------------------------------------
 Level::~Level( void )
 {
-    if( m_InitialLevelArray ) delete m_InitialLevelArray;
-    if( m_LevelArray ) delete m_LevelArray;
 }
 
 // --------------------------------------------------------------
 void Level::addMetaData( const std::string& key, const std::string& value )
 {
-    if( m_MetaData.find( key ) != m_MetaData.end() )
+    if( m_Text->metaData.find( key ) != m_Text->metaData.end() )
         throw Exception( std::string("[Level::addMetaData] Error: meta data \"") + key + "\" already exists" );
-    m_MetaData[key] = value;
+    this->getWritableText().metaData[key] = value;
 }
 
 // --------------------------------------------------------------
 const std::string& Level::getMetaData( const std::string& key )
 {
-    std::map<std::string, std::string>::iterator p = m_MetaData.find( key );
-    if( p == m_MetaData.end() )
+    std::map<std::string, std::string>::const_iterator p = m_Text->metaData.find( key );
+    if( p == m_Text->metaData.end() )
         throw Exception( std::string("[Level::getMetaData] Error: meta data \"") + key + "\" not found" );
     return p->second;
 }
@@ -85,24 +145,26 @@ const std::string& Level::getMetaData( const std::string& key )
 // --------------------------------------------------------------
 void Level::streamAllMetaData( std::ostream& stream )
 {
-    for( std::map<std::string, std::string>::iterator it = m_MetaData.begin(); it != m_MetaData.end(); ++it )
+    for( std::map<std::string, std::string>::const_iterator it = m_Text->metaData.begin(); it != m_Text->metaData.end(); ++it )
         stream << it->first << ": " << it->second << std::endl;
 }
 
 // --------------------------------------------------------------
 void Level::addHeaderData( const std::string& header )
 {
-    m_HeaderData.push_back( header );
+    this->getWritableText().headerData.push_back( header );
 }
 
 // --------------------------------------------------------------
 void Level::removeHeaderData( const std::string& header )
 {
-    for( std::vector<std::string>::iterator it = m_HeaderData.begin(); it != m_HeaderData.end(); ++it )
+    const std::vector<std::string>& headerData = m_Text->headerData;
+    for( std::size_t i = 0; i != headerData.size(); ++i )
     {
-        if( it->compare( header ) == 0 )
+        if( headerData[i].compare( header ) == 0 )
         {
-            m_HeaderData.erase( it );
+            std::vector<std::string>& writable = this->getWritableText().headerData;
+            writable.erase( writable.begin() + i );
             return;
         }
     }
@@ -114,7 +176,7 @@ void Level::removeHeaderData( const std::string& header )
 // --------------------------------------------------------------
 void Level::streamAllHeaderData( std::ostream& stream )
 {
-    for( std::vector<std::string>::iterator it = m_HeaderData.begin(); it != m_HeaderData.end(); ++it )
+    for( std::vector<std::string>::const_iterator it = m_Text->headerData.begin(); it != m_Text->headerData.end(); ++it )
         stream << *it << std::endl;
 }
 
@@ -128,9 +190,9 @@ void Level::insertTile( const std::size_t& x, const std::size_t& y, const char&
 
     // resize array if necessary
     if( x+1 > m_InitialLevelArray->sizeX() )
-        m_InitialLevelArray->resize( x+1, m_InitialLevelArray->sizeY() );
+        this->getWritableInitialLevelArray().resize( x+1, m_InitialLevelArray->sizeY() );
     if( y+1 > m_InitialLevelArray->sizeY() )
-        m_InitialLevelArray->resize( m_InitialLevelArray->sizeX(), y+1 );
+        this->getWritableInitialLevelArray().resize( m_InitialLevelArray->sizeX(), y+1 );
 
     // write tile
     this->setInitialTile( x, y, tile );
@@ -140,8 +202,23 @@ void Level::insertTile( const std::size_t& x, const std::size_t& y, const char&
 // --------------------------------------------------------------
 void Level::insertTileLine( const std::size_t& y, const std::string& tiles )
 {
-    for( std::size_t x = 0; x != tiles.size(); ++x )
-        this->insertTile( x, y, tiles[x] );
+    this->copyTileLines( y, &tiles, 1, "Level::insertTileLine" );
+}
+
+// --------------------------------------------------------------
+void Level::insertTileLines( const std::size_t& y, const std::vector<std::string>& lines )
+{
+    if( lines.empty() ) return;
+    this->copyTileLines( y, &lines[0], lines.size(), "Level::insertTileLines" );
+}
+
+// --------------------------------------------------------------
+void Level::insertTileLines( const std::size_t& y, const std::vector<std::string>& lines, const std::size_t& numLines )
+{
+    if( numLines > lines.size() )
+        throw Exception( "[Level::insertTileLines] Error: attempt to insert more lines than were passed" );
+    if( !numLines ) return;
+    this->copyTileLines( y, &lines[0], numLines, "Level::insertTileLines" );
 }
 
 // --------------------------------------------------------------
@@ -149,8 +226,7 @@ void Level::streamAllTileData( std::ostream& stream )
 {
     for( std::size_t y = 0; y != m_LevelArray->sizeY(); ++y )
     {
-        for( std::size_t x = 0; x != m_LevelArray->sizeX(); ++x )
-            stream << m_LevelArray->at(x,y);
+        stream.write( m_LevelArray->row(y), m_LevelArray->sizeX() );
         stream << std::endl;
     }
 }
@@ -162,8 +238,7 @@ void Level::streamInitialTileData( std::ostream& stream, bool newLine )
     // stream data
     for( std::size_t y = 0; y != m_InitialLevelArray->sizeY(); ++y )
     {
-        for( std::size_t x = 0; x != m_InitialLevelArray->sizeX(); ++x )
-            stream << m_InitialLevelArray->at(x,y);
+        stream.write( m_InitialLevelArray->row(y), m_InitialLevelArray->sizeX() );
         if( newLine )
             stream << std::endl;
         else
@@ -191,14 +266,15 @@ char Level::getTile( std::size_t x, std::size_t y ) const
 void Level::setInitialTile( const std::size_t& x, const std::size_t& y, const char& tile )
 {
     if( !Utils::isTileData(tile) ) throw Exception( std::string("[Level::setInitialTile] attempt to set tile to invalid character: \"") + tile + "\"" );
-    m_InitialLevelArray->at(x,y) = tile;
+    this->getWritableInitialLevelArray().at(x,y) = tile;
 }
 
 // --------------------------------------------------------------
 void Level::setTile( const std::size_t& x, const std::size_t& y, const char& tile )
 {
     if( !Utils::isTileData(tile) ) throw Exception( std::string("[Level::setTile] attempt to set tile to invalid character: \"") + tile + "\"" );
-    m_LevelArray->at(x,y) = tile;
+    this->getWritableLevelArray().at(x,y) = tile;
+    this->updateBitboardTile( x, y, tile );
     this->dispatchSetTile( x, y, tile );
 }
 
@@ -218,17 +294,19 @@ std::size_t Level::getSizeY( void ) const
 // --------------------------------------------------------------
 void Level::addLevelNote( const std::string& note )
 {
-    m_Notes.push_back( note );
+    this->getWritableText().notes.push_back( note );
 }
 
 // --------------------------------------------------------------
 void Level::removeLevelNote( const std::string& note)
 {
-    for( std::vector<std::string>::iterator it = m_Notes.begin(); it != m_Notes.end(); ++it )
+    const std::vector<std::string>& notes = m_Text->notes;
+    for( std::size_t i = 0; i != notes.size(); ++i )
     {
-        if( it->compare( note ) == 0 )
+        if( notes[i].compare( note ) == 0 )
         {
-            m_Notes.erase( it );
+            std::vector<std::string>& writable = this->getWritableText().notes;
+            writable.erase( writable.begin() + i );
             return;
         }
     }
@@ -240,14 +318,17 @@ void Level::removeLevelNote( const std::string& note)
 // --------------------------------------------------------------
 void Level::streamAllNotes( std::ostream& stream )
 {
-    for( std::vector<std::string>::iterator it = m_Notes.begin(); it != m_Notes.end(); ++it )
+    for( std::vector<std::string>::const_iterator it = m_Text->notes.begin(); it != m_Text->notes.end(); ++it )
         stream << *it << std::endl;
 }
 
 // --------------------------------------------------------------
 void Level::setLevelName( const std::string& name )
 {
+    if( name == m_LevelName ) return;
+    std::string oldName = m_LevelName;
     m_LevelName = name;
+    this->dispatchSetLevelName( oldName );
 }
 
 // --------------------------------------------------------------
@@ -262,11 +343,8 @@ std::string Level::exportUndoData( void )
 #ifdef _DEBUG
     std::cout << "exporting undo data" << std::endl;
 #endif
-    std::string undoData( m_UndoData.begin(), m_UndoData.end() );
-    std::cout << "size: " << undoData.size() << ", undoDataPos: " << m_UndoDataPos << std::endl;
-    std::cout << "(bool) will export undo data: " << (this->undoDataExists() || this->redoDataExists() ) << std::endl;
-    if( this->undoDataExists() || this->redoDataExists() ) undoData.insert( m_UndoDataPos, "*" );
-    std::cout << "success" << std::endl;
+    std::string undoData = m_UndoHistory.toString();
+    if( this->undoDataExists() || this->redoDataExists() ) undoData.insert( m_UndoHistory.getPosition(), "*" );
     return undoData;
 }
 
@@ -280,27 +358,34 @@ void Level::importUndoData( const std::string& undoData )
     if( undoData.size() == 0 )
         throw Exception( std::string("[Level::importUndoData] Undo data string is empty") );
 
-    // prepare undo data by extracting the current position (marked by a '*'),
-    // and validating the characters
-    std::vector<char> tmp( undoData.begin(), undoData.end() );
+    // undo data may be RLE compressed
+    std::string expanded;
+    RLE rle;
+    rle.decompress( undoData.data(), undoData.size(), expanded );
+
+    // extract the current position (marked by a '*') and validate the
+    // characters. Without a marker, all moves have been made.
+    std::string moves;
+    moves.reserve( expanded.size() );
     std::size_t pos = 0;
-    for( std::vector<char>::iterator it = tmp.begin(); it != tmp.end(); ++it )
+    bool foundMarker = false;
+    for( std::string::const_iterator it = expanded.begin(); it != expanded.end(); ++it )
     {
-        if( *it == '*' )
+        if( *it == '*' && !foundMarker )
         {
-            tmp.erase( it );
-            break;
+            pos = moves.size();
+            foundMarker = true;
+            continue;
         }
-        ++pos;
-
-        // validate characters
         if( !Utils::isUndoData(*it) )
             throw Exception( std::string("[Level::importUndoData] Invalid character found in undo data string: \"") + (*it) + "\". Import failed." );
+        moves.push_back( *it );
     }
 
+    if( !foundMarker ) pos = moves.size();
+
     // save undo data and current position
-    m_UndoData = tmp;
-    m_UndoDataPos = pos; // results in 0 if there is no undo data
+    m_UndoHistory.assign( moves, pos );
 }
 
 // --------------------------------------------------------------
@@ -313,20 +398,76 @@ void Level::applyUndoData( void )
     if( !m_IsLevelValid )
         throw Exception( "[Collection::applyUndoData] Error: cannot apply undo data to invalid levels" );
 
-    // fast forward
-    if( this->undoDataExists() )
-        for( std::size_t pos = 0; pos != m_UndoDataPos; ++pos )
-            this->movePlayer( m_UndoData.at(pos), false ); // don't update undo data
+    // fast forward without informing listeners of every single move. The
+    // imported moves aren't checked against the board, so the history is
+    // cut off at the first move which can't be made or which pushes a box
+    // when it shouldn't (or the other way around).
+    this->reset();
+    bool isPushingBox;
+    for( std::size_t pos = 0; pos != m_UndoHistory.getPosition(); ++pos )
+    {
+        char move = m_UndoHistory.at( pos );
+        bool isMoved = this->stepPlayer( move, isPushingBox );
+        if( isMoved && isPushingBox == ( move < 'a' ) )
+            continue;
+
+        while( m_UndoHistory.getPosition() != pos )
+            m_UndoHistory.undo();
+        m_UndoHistory.truncate();
+
+        // a move with the wrong push was still made, so play the others again
+        if( isMoved )
+        {
+            this->reset();
+            for( std::size_t i = 0; i != pos; ++i )
+                this->stepPlayer( m_UndoHistory.at(i), isPushingBox );
+        }
+        break;
+    }
+    this->dispatchReplaceBoard();
 
 }
 
+// --------------------------------------------------------------
+void Level::applyMoves( const std::string& moves )
+{
+    if( !m_IsLevelValid )
+        throw Exception( "[Level::applyMoves] Error: cannot apply moves to invalid levels" );
+    for( std::string::const_iterator it = moves.begin(); it != moves.end(); ++it )
+        if( !Utils::isUndoData(*it) )
+            throw Exception( std::string("[Level::applyMoves] Error: invalid move \"") + (*it) + "\"" );
+
+    // moves which aren't possible are skipped, just like when playing
+    bool isPushingBox;
+    for( std::string::const_iterator it = moves.begin(); it != moves.end(); ++it )
+    {
+        if( !this->stepPlayer( *it, isPushingBox ) ) continue;
+        char move = *it;
+        if( move >= 'a' ) move -= 32;
+        if( !isPushingBox ) move += 32;
+        m_UndoHistory.push( move );
+    }
+    this->dispatchReplaceBoard();
+}
+
 // --------------------------------------------------------------
 void Level::reset( void )
 {
 #ifdef _DEBUG
     std::cout << "resetting level" << std::endl;
 #endif
-    *m_LevelArray = *m_InitialLevelArray;
+
+    // the boards are shared until the first move. A board which was already
+    // copied is overwritten instead, so playing again doesn't allocate
+    if( m_OwnsLevelArray )
+        *m_LevelArray = *m_InitialLevelArray;
+    else
+    {
+        m_LevelArray = m_InitialLevelArray;
+        m_OwnsInitialLevelArray = false;
+    }
+    this->updateBitboards();
+    m_HasUnrecordedMoves = false;
 }
 
 // --------------------------------------------------------------
@@ -335,8 +476,7 @@ void Level::clearUndoData( void )
 #ifdef _DEBUG
     std::cout << "clearing undo data" << std::endl;
 #endif
-    m_UndoData.clear();
-    m_UndoDataPos = 0;
+    m_UndoHistory.clear();
 }
 
 // --------------------------------------------------------------
@@ -374,10 +514,30 @@ void Level::validateLevel( void )
     }
     if( !playerFound ) throw Exception( "[Level::validateLevel] Error: No player was found on this level." );
 
+    this->calculateDeadSquares();
+
     // arriving here means the level is valid
     m_IsLevelValid = true;
 }
 
+// --------------------------------------------------------------
+bool Level::isValid( void ) const
+{
+    return m_IsLevelValid;
+}
+
+// --------------------------------------------------------------
+std::size_t Level::getPlayerX( void ) const
+{
+    return m_PlayerX;
+}
+
+// --------------------------------------------------------------
+std::size_t Level::getPlayerY( void ) const
+{
+    return m_PlayerY;
+}
+
 // --------------------------------------------------------------
 void Level::moveUp( void )
 {
@@ -414,7 +574,64 @@ void Level::movePlayer( char direction, bool updateUndoData )
         return;
     }
 
+    // remember where everything was, the step moves the player
+    std::size_t oldX = m_PlayerX, oldY = m_PlayerY;
     bool isPushingBox = false;
+    if( !this->stepPlayer( direction, isPushingBox ) ) return;
+    std::size_t newX = m_PlayerX, newY = m_PlayerY;
+    std::size_t nextX = newX + (newX-oldX);
+    std::size_t nextY = newY + (newY-oldY);
+    std::size_t newIndex = m_WallBoard.index( newX, newY );
+    std::size_t nextIndex = m_WallBoard.index( nextX, nextY );
+
+    // inform listeners
+    if( isPushingBox )
+    {
+        this->dispatchSetTile( nextX, nextY, m_LevelArray->row(nextY)[nextX] );
+        this->dispatchMoveTile( newX, newY, nextX, nextY );
+    }
+    this->dispatchSetTile( newX, newY, m_LevelArray->row(newY)[newX] );
+    this->dispatchSetTile( oldX, oldY, m_LevelArray->row(oldY)[oldX] );
+    this->dispatchMoveTile( oldX, oldY, newX, newY );
+
+    // check if the push made the level unsolvable
+    if( isPushingBox && m_DetectDeadlocks )
+    {
+        if( !m_DeadlockDetector.isPrepared() )
+            m_DeadlockDetector.prepare( *this );
+        DeadlockDetector::Type type = m_DeadlockDetector.check( m_BoxBoard, newIndex, nextIndex );
+        if( type != DeadlockDetector::DEADLOCK_NONE )
+            this->dispatchDeadlock( nextX, nextY, type );
+    }
+
+    // generate undo data
+    if( updateUndoData )
+    {
+        if( direction >= 'a' ) direction -= 32; // upper case is used for pushing boxes
+        if( !isPushingBox ) direction += 32;
+        m_UndoHistory.push( direction );
+    }
+}
+
+// --------------------------------------------------------------
+Level::StepResult Level::step( const char& direction )
+{
+    if( !m_IsLevelValid || !Utils::isUndoData( direction ) )
+        return STEP_BLOCKED;
+
+    bool isPushingBox;
+    if( !this->stepPlayer( direction, isPushingBox ) )
+        return STEP_BLOCKED;
+    m_HasUnrecordedMoves = true;
+    if( !isPushingBox )
+        return STEP_MOVED;
+    return ( this->isSolved() ? STEP_SOLVED : STEP_PUSHED );
+}
+
+// --------------------------------------------------------------
+bool Level::stepPlayer( char direction, bool& isPushingBox )
+{
+    isPushingBox = false;
 
     // convert to lower case
     if( direction == 'U' || direction == 'D' || direction == 'L' || direction == 'R' ) direction += 32;
@@ -430,56 +647,53 @@ void Level::movePlayer( char direction, bool updateUndoData )
     std::size_t nextX = newX + (newX-m_PlayerX);
     std::size_t nextY = newY + (newY-m_PlayerY);
 
+    // bit indices of the affected squares
+    std::size_t oldIndex = m_WallBoard.index( m_PlayerX, m_PlayerY );
+    std::size_t newIndex = m_WallBoard.index( newX, newY );
+    std::size_t nextIndex = m_WallBoard.index( nextX, nextY );
+
     // can't move if there is a wall
-    if( m_LevelArray->at(newX,newY) == '#' ) return;
+    if( m_WallBoard.test(newIndex) ) return false;
 
     // can't move if box is against a wall or another box
-    if( m_LevelArray->at(newX,newY) == '$' || m_LevelArray->at(newX,newY) == '*' )
+    if( m_BoxBoard.test(newIndex) )
     {
-        if( m_LevelArray->at(nextX,nextY) == '#' ||
-            m_LevelArray->at(nextX,nextY) == '$' ||
-            m_LevelArray->at(nextX,nextY) == '*' )
-            return;
+        if( m_WallBoard.test(nextIndex) || m_BoxBoard.test(nextIndex) )
+            return false;
+        if( m_RefuseDeadlyPushes && m_DeadSquareBoard.test(nextIndex) )
+            return false;
         isPushingBox = true;
     }
 
     // move box (if any)
     if( isPushingBox )
     {
-        if( m_LevelArray->at(newX,newY) == '$' )
-            m_LevelArray->at(newX,newY) = ' ';   // box is on floor, expose floor
+        if( m_GoalBoard.test(nextIndex) )
+            this->placeTile( nextX, nextY, '*' );   // target is goal, place box on goal
         else
-            m_LevelArray->at(newX,newY) = '.';   // box is on goal, expose goal
-        if( m_LevelArray->at(nextX,nextY) == '.' )
-            this->setTile( nextX, nextY, '*' );   // target is goal, place box on goal
-        else
-            this->setTile( nextX, nextY, '$' );     // target is floor, place box on floor
-        this->dispatchMoveTile( newX, newY, nextX, nextY );
+            this->placeTile( nextX, nextY, '$' );   // target is floor, place box on floor
     }
 
-    // move player
-    if( m_LevelArray->at(newX,newY) == ' ' )
-        this->setTile( newX, newY, '@' );     // target is floor, place player on floor
+    // move player, which also takes the box off its old square
+    if( m_GoalBoard.test(newIndex) )
+        this->placeTile( newX, newY, '+' );     // target is goal, place player on goal
     else
-        this->setTile( newX, newY, '+' );     // target is goal, place player on goal
-    if( m_LevelArray->at(m_PlayerX,m_PlayerY) == '@')
-        this->setTile( m_PlayerX, m_PlayerY, ' ' );
+        this->placeTile( newX, newY, '@' );     // target is floor, place player on floor
+    if( m_GoalBoard.test(oldIndex) )
+        this->placeTile( m_PlayerX, m_PlayerY, '.' );
     else
-        this->setTile( m_PlayerX, m_PlayerY, '.' );
-    this->dispatchMoveTile( m_PlayerX, m_PlayerY, newX, newY );
+        this->placeTile( m_PlayerX, m_PlayerY, ' ' );
     m_PlayerX = newX;
     m_PlayerY = newY;
 
-    // generate undo data
-    if( updateUndoData )
-    {
-        if( isPushingBox ) direction -= 32; // convert to upper case for pushing boxes
-        if( this->undoDataExists() )
-            while( m_UndoData.size() != m_UndoDataPos )
-                m_UndoData.pop_back();
-        m_UndoData.push_back( direction );
-        ++m_UndoDataPos;
-    }
+    return true;
+}
+
+// --------------------------------------------------------------
+void Level::placeTile( const std::size_t& x, const std::size_t& y, const char& tile )
+{
+    this->getWritableLevelArray().row(y)[x] = tile;
+    this->updateBitboardTile( x, y, tile );
 }
 
 // --------------------------------------------------------------
@@ -493,11 +707,10 @@ bool Level::undo( void )
         return false;
     }
 
-    if( !this->undoDataExists() ) return false;
+    if( !this->undoDataExists() || m_HasUnrecordedMoves ) return false;
 
-    // get undo move
-    char move = m_UndoData.at( m_UndoDataPos-1 );
-    --m_UndoDataPos;
+    // get undo move, it is only taken from the history once it fits the board
+    char move = m_UndoHistory.at( m_UndoHistory.getPosition()-1 );
 
     // determine if a box was pushed and convert to lower case
     bool boxPushed = false;
@@ -518,28 +731,39 @@ bool Level::undo( void )
     std::size_t previousX = m_PlayerX + (m_PlayerX-oldX);
     std::size_t previousY = m_PlayerY + (m_PlayerY-oldY);
 
+    // the player has to come from a free square on the board, and a pushed
+    // box has to be in front of the player
+    if( oldX >= m_LevelArray->sizeX() || oldY >= m_LevelArray->sizeY() )
+        return false;
+    if( boxPushed && (previousX >= m_LevelArray->sizeX() || previousY >= m_LevelArray->sizeY()) )
+        return false;
+    std::size_t oldIndex = m_WallBoard.index( oldX, oldY );
+    std::size_t playerIndex = m_WallBoard.index( m_PlayerX, m_PlayerY );
+    std::size_t previousIndex = m_WallBoard.index( previousX, previousY );
+    if( m_WallBoard.test(oldIndex) || m_BoxBoard.test(oldIndex) )
+        return false;
+    if( boxPushed && !m_BoxBoard.test(previousIndex) )
+        return false;
+    m_UndoHistory.undo();
+
     // revert back player position
-    if( m_LevelArray->at(m_PlayerX,m_PlayerY) == '@' )
-        this->setTile( m_PlayerX, m_PlayerY, ' ' );
-    else
-        this->setTile( m_PlayerX, m_PlayerY, '.' );
-    if( m_LevelArray->at(oldX,oldY) == ' ' )
-        this->setTile( oldX, oldY, '@' );
-    else
-        this->setTile( oldX, oldY, '+' );
+    char tile = ( m_GoalBoard.test(playerIndex) ? '.' : ' ' );
+    this->placeTile( m_PlayerX, m_PlayerY, tile );
+    this->dispatchSetTile( m_PlayerX, m_PlayerY, tile );
+    tile = ( m_GoalBoard.test(oldIndex) ? '+' : '@' );
+    this->placeTile( oldX, oldY, tile );
+    this->dispatchSetTile( oldX, oldY, tile );
     this->dispatchMoveTile( m_PlayerX, m_PlayerY, oldX, oldY );
 
     // player was pushing a box
     if( boxPushed )
     {
-        if( m_LevelArray->at(previousX,previousY) == '$' )
-            this->setTile( previousX, previousY, ' ' );
-        else
-            this->setTile( previousX, previousY, '.' );
-        if( m_LevelArray->at(m_PlayerX,m_PlayerY) == ' ')
-            this->setTile( m_PlayerX, m_PlayerY, '$' );
-        else
-            this->setTile( m_PlayerX, m_PlayerY, '*' );
+        tile = ( m_GoalBoard.test(previousIndex) ? '.' : ' ' );
+        this->placeTile( previousX, previousY, tile );
+        this->dispatchSetTile( previousX, previousY, tile );
+        tile = ( m_GoalBoard.test(playerIndex) ? '*' : '$' );
+        this->placeTile( m_PlayerX, m_PlayerY, tile );
+        this->dispatchSetTile( m_PlayerX, m_PlayerY, tile );
         this->dispatchMoveTile( previousX, previousY, m_PlayerX, m_PlayerY );
     }
     m_PlayerX = oldX;
@@ -551,23 +775,157 @@ bool Level::undo( void )
 // --------------------------------------------------------------
 bool Level::redo( void )
 {
-    if( !this->redoDataExists() ) return false;
-    char move = m_UndoData.at( m_UndoDataPos );
+    if( !m_IsLevelValid || !this->redoDataExists() || m_HasUnrecordedMoves ) return false;
+
+    // the move is only taken from the history once it was made with the
+    // same push as before
+    char move = m_UndoHistory.at( m_UndoHistory.getPosition() );
+    std::size_t newX = m_PlayerX, newY = m_PlayerY;
+    if( move == 'u' || move == 'U' ) --newY;
+    if( move == 'd' || move == 'D' ) ++newY;
+    if( move == 'l' || move == 'L' ) --newX;
+    if( move == 'r' || move == 'R' ) ++newX;
+    if( m_BoxBoard.test( m_WallBoard.index(newX, newY) ) != ( move < 'a' ) )
+        return false;
     this->movePlayer( move, false );
-    ++m_UndoDataPos;
+    if( m_PlayerX != newX || m_PlayerY != newY )
+        return false;
+    m_UndoHistory.redo();
     return true;
 }
 
 // --------------------------------------------------------------
 bool Level::undoDataExists( void )
 {
-    return ( m_UndoDataPos != 0 );
+    return m_UndoHistory.canUndo();
 }
 
 // --------------------------------------------------------------
 bool Level::redoDataExists( void )
 {
-    return ( m_UndoDataPos < m_UndoData.size() );
+    return m_UndoHistory.canRedo();
+}
+
+// --------------------------------------------------------------
+const UndoHistory& Level::getUndoHistory( void ) const
+{
+    return m_UndoHistory;
+}
+
+// --------------------------------------------------------------
+void Level::setUndoBranching( const bool& enable )
+{
+    m_UndoHistory.setBranching( enable );
+}
+
+// --------------------------------------------------------------
+bool Level::getUndoBranching( void ) const
+{
+    return m_UndoHistory.getBranching();
+}
+
+// --------------------------------------------------------------
+std::size_t Level::getNumRedoBranches( void ) const
+{
+    return m_UndoHistory.getNumBranches();
+}
+
+// --------------------------------------------------------------
+void Level::selectRedoBranch( const std::size_t& index )
+{
+    m_UndoHistory.selectBranch( index );
+}
+
+// --------------------------------------------------------------
+bool Level::isSolved( void ) const
+{
+    return m_BoxBoard.isSubsetOf( m_GoalBoard );
+}
+
+// --------------------------------------------------------------
+void Level::getPlayerReachableArea( Bitboard& reachable ) const
+{
+
+    // everything that isn't a wall or a box can be walked on
+    Bitboard passable( m_WallBoard );
+    passable |= m_BoxBoard;
+    passable.invert();
+
+    reachable.resize( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    reachable.set( m_WallBoard.index( m_PlayerX, m_PlayerY ) );
+    reachable.floodFill( passable );
+}
+
+// --------------------------------------------------------------
+bool Level::isDeadSquare( const std::size_t& x, const std::size_t& y ) const
+{
+    if( x >= m_DeadSquareBoard.sizeX() || y >= m_DeadSquareBoard.sizeY() )
+        return false;
+    return m_DeadSquareBoard.test( m_DeadSquareBoard.index( x, y ) );
+}
+
+// --------------------------------------------------------------
+const Bitboard& Level::getDeadSquareBoard( void ) const
+{
+    return m_DeadSquareBoard;
+}
+
+// --------------------------------------------------------------
+void Level::setRefuseDeadlyPushes( const bool& refuse )
+{
+    m_RefuseDeadlyPushes = refuse;
+}
+
+// --------------------------------------------------------------
+bool Level::getRefuseDeadlyPushes( void ) const
+{
+    return m_RefuseDeadlyPushes;
+}
+
+// --------------------------------------------------------------
+void Level::setDeadlockDetection( const bool& enable )
+{
+    m_DetectDeadlocks = enable;
+}
+
+// --------------------------------------------------------------
+bool Level::getDeadlockDetection( void ) const
+{
+    return m_DetectDeadlocks;
+}
+
+// --------------------------------------------------------------
+Uint64 Level::getStateHash( void ) const
+{
+
+    // the reachable region only changes when a box or wall changes, so
+    // walking around doesn't require another flood fill
+    if( m_IsPlayerRegionDirty )
+    {
+        Bitboard reachable;
+        this->getPlayerReachableArea( reachable );
+        m_NormalisedPlayer = reachable.findFirst();
+        m_IsPlayerRegionDirty = false;
+    }
+    return m_BoxHash ^ zobristKey( m_NormalisedPlayer, ZOBRIST_PLAYER );
+}
+
+// --------------------------------------------------------------
+const Bitboard& Level::getWallBoard( void ) const
+{
+    return m_WallBoard;
+}
+
+// --------------------------------------------------------------
+const Bitboard& Level::getGoalBoard( void ) const
+{
+    return m_GoalBoard;
+}
+
+// --------------------------------------------------------------
+const Bitboard& Level::getBoxBoard( void ) const
+{
+    return m_BoxBoard;
 }
 
 // --------------------------------------------------------------
@@ -593,6 +951,213 @@ void Level::removeListener( LevelListener* listener )
     throw Exception( "[Level::removeListener] Error: Listener could not be removed, as it wasn't registered as a listener to begin with" );
 }
 
+// --------------------------------------------------------------
+void Level::replaceListener( LevelListener* oldListener, LevelListener* newListener ) noexcept
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+    {
+        if( (*it) == oldListener )
+        {
+            *it = newListener;
+            return;
+        }
+    }
+}
+
+// --------------------------------------------------------------
+void Level::calculateDeadSquares( void )
+{
+    std::size_t sizeX = m_InitialLevelArray->sizeX(), sizeY = m_InitialLevelArray->sizeY();
+    Bitboard walls( sizeX, sizeY );
+    Bitboard alive( sizeX, sizeY );
+    std::vector<std::size_t> queue;
+
+    // walls and goals never move, so the initial tiles are enough
+    walls.setBorder();
+    for( std::size_t y = 0; y != sizeY; ++y )
+    {
+        const char* row = m_InitialLevelArray->row(y);
+        for( std::size_t x = 0; x != sizeX; ++x )
+        {
+            std::size_t index = walls.index( x, y );
+            if( row[x] == '#' ) walls.set( index );
+            if( row[x] == '.' || row[x] == '*' || row[x] == '+' )
+            {
+                alive.set( index );
+                queue.push_back( index );
+            }
+        }
+    }
+
+    // the player can never get to squares outside of its region
+    Bitboard region( sizeX, sizeY );
+    Bitboard passable( walls );
+    passable.invert();
+    region.set( walls.index( m_PlayerX, m_PlayerY ) );
+    region.floodFill( passable );
+
+    // pull boxes away from the goals. A box can be pulled off a square if the
+    // square it's pulled onto and the square behind that are in the player's
+    // region. Every square reached this way can have its box pushed back
+    // onto a goal.
+    std::size_t delta[4] = { static_cast<std::size_t>(0)-walls.stride(), walls.stride(),
+                             static_cast<std::size_t>(0)-1, 1 };
+    for( std::size_t head = 0; head != queue.size(); ++head )
+    {
+        for( std::size_t direction = 0; direction != 4; ++direction )
+        {
+            std::size_t from = queue[head] + delta[direction];
+            std::size_t pusher = from + delta[direction];
+            if( !region.test(from) || !region.test(pusher) || alive.test(from) ) continue;
+            alive.set( from );
+            queue.push_back( from );
+        }
+    }
+
+    // every other floor square is dead
+    m_DeadSquareBoard = walls;
+    m_DeadSquareBoard.invert();
+    m_DeadSquareBoard.andNot( alive );
+}
+
+// --------------------------------------------------------------
+void Level::updateBitboards( void )
+{
+    m_WallBoard.resize( m_LevelArray->sizeX(), m_LevelArray->sizeY() );
+    m_GoalBoard.resize( m_LevelArray->sizeX(), m_LevelArray->sizeY() );
+    m_BoxBoard.resize( m_LevelArray->sizeX(), m_LevelArray->sizeY() );
+    m_BoxHash = 0;
+    m_IsPlayerRegionDirty = true;
+
+    // the padding border acts as a wall so the player can never leave the level
+    m_WallBoard.setBorder();
+    bool playerFound = false;
+    for( std::size_t y = 0; y != m_LevelArray->sizeY(); ++y )
+    {
+        const char* row = m_LevelArray->row(y);
+        for( std::size_t x = 0; x != m_LevelArray->sizeX(); ++x )
+        {
+            this->updateBitboardTile( x, y, row[x] );
+
+            // the player returns to where it started
+            if( row[x] == '@' || row[x] == '+' )
+            {
+                m_PlayerX = x;
+                m_PlayerY = y;
+                playerFound = true;
+            }
+        }
+    }
+    if( !playerFound ) return;
+
+    // floor outside of the player's region can never be entered, so it is
+    // walled off as well. Together with the border this means every step
+    // and push ends on the board, and moving needs no bounds checks. Only
+    // the wall board changes, the tiles are kept as they are.
+    Bitboard outside( m_WallBoard.sizeX(), m_WallBoard.sizeY() );
+    Bitboard passable( m_WallBoard );
+    passable.invert();
+    outside.set( m_WallBoard.index( m_PlayerX, m_PlayerY ) );
+    outside.floodFill( passable );
+    outside.invert();
+    outside.andNot( m_BoxBoard );
+    outside.andNot( m_GoalBoard );
+    m_WallBoard |= outside;
+}
+
+// --------------------------------------------------------------
+void Level::updateBitboardTile( const std::size_t& x, const std::size_t& y, const char& tile )
+{
+    std::size_t index = m_WallBoard.index( x, y );
+    if( tile == '.' || tile == '*' || tile == '+' ) m_GoalBoard.set( index ); else m_GoalBoard.reset( index );
+
+    // walls and boxes change the region the player can walk in
+    bool isWall = ( tile == '#' );
+    if( isWall != m_WallBoard.test(index) )
+    {
+        if( isWall ) m_WallBoard.set( index ); else m_WallBoard.reset( index );
+        m_IsPlayerRegionDirty = true;
+    }
+    bool isBox = ( tile == '$' || tile == '*' );
+    if( isBox != m_BoxBoard.test(index) )
+    {
+        if( isBox ) m_BoxBoard.set( index ); else m_BoxBoard.reset( index );
+        m_BoxHash ^= zobristKey( index, ZOBRIST_BOX );
+        m_IsPlayerRegionDirty = true;
+    }
+}
+
+// --------------------------------------------------------------
+void Level::copyTileLines( const std::size_t& y, const std::string* lines, const std::size_t& numLines, const char* caller )
+{
+
+    // check all characters and find the size of the board first
+    std::size_t sizeX = m_InitialLevelArray->sizeX();
+    std::size_t sizeY = std::max( m_InitialLevelArray->sizeY(), y + numLines );
+    for( std::size_t i = 0; i != numLines; ++i )
+    {
+        for( std::string::const_iterator it = lines[i].begin(); it != lines[i].end(); ++it )
+            if( !Utils::isTileData( *it ) )
+                throw Exception( std::string("[") + caller + "] Error: attempt to insert invalid character \"" + *it + "\" into level array" );
+        sizeX = std::max( sizeX, lines[i].size() );
+    }
+
+    // resize once, then copy the lines row by row
+    LevelArray_t& tiles = this->getWritableInitialLevelArray();
+    if( sizeX != tiles.sizeX() || sizeY != tiles.sizeY() )
+        tiles.resize( sizeX, sizeY );
+    for( std::size_t i = 0; i != numLines; ++i )
+        if( !lines[i].empty() )
+            std::copy( lines[i].begin(), lines[i].end(), tiles.row( y+i ) );
+}
+
+// --------------------------------------------------------------
+const std::shared_ptr<Level::LevelText>& Level::getEmptyText( void )
+{
+    static const std::shared_ptr<LevelText> empty( std::make_shared<LevelText>() );
+    return empty;
+}
+
+// --------------------------------------------------------------
+const std::shared_ptr<LevelArray_t>& Level::getEmptyLevelArray( void )
+{
+    static const std::shared_ptr<LevelArray_t> empty( std::make_shared<LevelArray_t>( ' ' ) );
+    return empty;
+}
+
+// --------------------------------------------------------------
+Level::LevelText& Level::getWritableText( void )
+{
+    if( !m_OwnsText )
+    {
+        m_Text = std::make_shared<LevelText>( *m_Text );
+        m_OwnsText = true;
+    }
+    return *m_Text;
+}
+
+// --------------------------------------------------------------
+LevelArray_t& Level::getWritableLevelArray( void )
+{
+    if( !m_OwnsLevelArray )
+    {
+        m_LevelArray = std::make_shared<LevelArray_t>( *m_LevelArray );
+        m_OwnsLevelArray = true;
+    }
+    return *m_LevelArray;
+}
+
+// --------------------------------------------------------------
+LevelArray_t& Level::getWritableInitialLevelArray( void )
+{
+    if( !m_OwnsInitialLevelArray )
+    {
+        m_InitialLevelArray = std::make_shared<LevelArray_t>( *m_InitialLevelArray );
+        m_OwnsInitialLevelArray = true;
+    }
+    return *m_InitialLevelArray;
+}
+
 // --------------------------------------------------------------
 void Level::dispatchSetTile( const std::size_t& x, const std::size_t& y, const char& tile )
 {
@@ -600,6 +1165,20 @@ void Level::dispatchSetTile( const std::size_t& x, const std::size_t& y, const c
         (*it)->onSetTile( x, y, tile );
 }
 
+// --------------------------------------------------------------
+void Level::dispatchReplaceBoard( void )
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+        (*it)->onReplaceBoard();
+}
+
+// --------------------------------------------------------------
+void Level::dispatchDeadlock( const std::size_t& x, const std::size_t& y, const DeadlockDetector::Type& type )
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+        (*it)->onDeadlock( x, y, type );
+}
+
 // --------------------------------------------------------------
 void Level::dispatchMoveTile( const std::size_t& oldX, const std::size_t& oldY, const std::size_t& newX, const std::size_t& newY )
 {
@@ -607,27 +1186,82 @@ void Level::dispatchMoveTile( const std::size_t& oldX, const std::size_t& oldY,
         (*it)->onMoveTile( oldX, oldY, newX, newY );
 }
 
+// --------------------------------------------------------------
+void Level::dispatchSetLevelName( const std::string& oldName )
+{
+    for( std::vector<LevelListener*>::iterator it = m_LevelListeners.begin(); it != m_LevelListeners.end(); ++it )
+        (*it)->onSetLevelName( *this, oldName );
+}
+
 // --------------------------------------------------------------
 Level& Level::operator=( const Level& that )
 {
     if( &that == this ) return *this;
 
     // shallow copies
-    m_MetaData          = that.m_MetaData;
-    m_HeaderData        = that.m_HeaderData;
-    m_Notes             = that.m_Notes;
-    m_UndoData          = that.m_UndoData;
+    m_Text              = that.m_Text;
+    m_UndoHistory       = that.m_UndoHistory;
     m_LevelName         = that.m_LevelName;
     m_LevelListeners    = that.m_LevelListeners;
     m_PlayerX           = that.m_PlayerX;
     m_PlayerY           = that.m_PlayerY;
     m_IsLevelValid      = that.m_IsLevelValid;
+    m_WallBoard         = that.m_WallBoard;
+    m_GoalBoard         = that.m_GoalBoard;
+    m_BoxBoard          = that.m_BoxBoard;
+    m_HasUnrecordedMoves = that.m_HasUnrecordedMoves;
+    m_BoxHash           = that.m_BoxHash;
+    m_NormalisedPlayer  = that.m_NormalisedPlayer;
+    m_IsPlayerRegionDirty = that.m_IsPlayerRegionDirty;
+    m_DeadSquareBoard   = that.m_DeadSquareBoard;
+    m_RefuseDeadlyPushes = that.m_RefuseDeadlyPushes;
+    m_DeadlockDetector  = that.m_DeadlockDetector;
+    m_DetectDeadlocks   = that.m_DetectDeadlocks;
+
+    // the text and boards are shared until either level changes them
+    m_InitialLevelArray = that.m_InitialLevelArray;
+    m_LevelArray = that.m_LevelArray;
+    m_OwnsText = m_OwnsLevelArray = m_OwnsInitialLevelArray = false;
+    that.m_OwnsText = that.m_OwnsLevelArray = that.m_OwnsInitialLevelArray = false;
 
-    // deep copy level arrays
-    *m_InitialLevelArray = *that.m_InitialLevelArray;
-    *m_LevelArray = *that.m_LevelArray;
+    return *this;
+}
 
+// --------------------------------------------------------------
+Level& Level::operator=( Level&& that ) noexcept
+{
+    this->swap( that );
     return *this;
 }
 
+// --------------------------------------------------------------
+void Level::swap( Level& that ) noexcept
+{
+    if( &that == this ) return;
+
+    m_Text.swap( that.m_Text );
+    m_LevelArray.swap( that.m_LevelArray );
+    m_InitialLevelArray.swap( that.m_InitialLevelArray );
+    std::swap( m_OwnsText, that.m_OwnsText );
+    std::swap( m_OwnsLevelArray, that.m_OwnsLevelArray );
+    std::swap( m_OwnsInitialLevelArray, that.m_OwnsInitialLevelArray );
+    m_LevelName.swap( that.m_LevelName );
+    m_LevelListeners.swap( that.m_LevelListeners );
+    m_WallBoard.swap( that.m_WallBoard );
+    m_GoalBoard.swap( that.m_GoalBoard );
+    m_BoxBoard.swap( that.m_BoxBoard );
+    std::swap( m_PlayerX, that.m_PlayerX );
+    std::swap( m_PlayerY, that.m_PlayerY );
+    m_UndoHistory.swap( that.m_UndoHistory );
+    std::swap( m_HasUnrecordedMoves, that.m_HasUnrecordedMoves );
+    std::swap( m_BoxHash, that.m_BoxHash );
+    std::swap( m_NormalisedPlayer, that.m_NormalisedPlayer );
+    std::swap( m_IsPlayerRegionDirty, that.m_IsPlayerRegionDirty );
+    m_DeadSquareBoard.swap( that.m_DeadSquareBoard );
+    std::swap( m_RefuseDeadlyPushes, that.m_RefuseDeadlyPushes );
+    m_DeadlockDetector.swap( that.m_DeadlockDetector );
+    std::swap( m_DetectDeadlocks, that.m_DetectDeadlocks );
+    std::swap( m_IsLevelValid, that.m_IsLevelValid );
+}
+
 } // namespace Chocobun
@@ -27,17 +27,21 @@
 
 #include <core/Config.hpp>
 #include <core/Typedefs.hpp>
+#include <core/Bitboard.hpp>
+#include <core/DeadlockDetector.hpp>
+#include <core/UndoHistory.hpp>
+#include <core/Array2D.hxx>
 
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include <iostream>
 
 namespace Chocobun {
 
 class LevelListener;
-template <class T> class Array2D;
 
 /*!
  * @brief Holds information of a loaded level
@@ -46,6 +50,17 @@ class Level
 {
 public:
 
+    /*!
+     * @brief What a call to @a step did
+     */
+    enum StepResult
+    {
+        STEP_BLOCKED,   //!< Nothing moved, the player ran into a wall or an immovable box
+        STEP_MOVED,     //!< The player moved without pushing a box
+        STEP_PUSHED,    //!< The player pushed a box and the level isn't solved yet
+        STEP_SOLVED     //!< The player pushed a box and every box is on a goal now
+    };
+
     /*!
      * @brief Default Constructor
      */
@@ -53,9 +68,19 @@ public:
 
     /*!
      * @brief Copy constructor
+     * The boards and text are shared with the other level until either of
+     * them changes. The copy may be used by another thread than the
+     * original, as long as each level is only used by one thread at a time.
      */
     Level( const Level& that );
 
+    /*!
+     * @brief Move constructor
+     * Takes over everything of the other level without copying it. The
+     * other level is left empty.
+     */
+    Level( Level&& that ) noexcept;
+
     /*!
      * @brief Destructor
      */
@@ -154,6 +179,31 @@ public:
      */
     void insertTileLine( const std::size_t& y, const std::string& tiles );
 
+    /*!
+     * @brief Inserts many lines of tiles at once
+     * All lines are checked and the map array is resized once before any
+     * tile is written, so building a level from all of its lines takes time
+     * linear in its number of tiles. Valid tile characters are the same as
+     * for @a insertTileLine.
+     * @exception Chocobun::Exception if an invalid character is passed. No
+     * tile is inserted in that case.
+     * @param y The Y coordinate for the first line to insert
+     * @param lines The lines of tiles to insert, one after another
+     */
+    void insertTileLines( const std::size_t& y, const std::vector<std::string>& lines );
+
+    /*!
+     * @brief Inserts the first lines of a vector at once
+     * This lets the caller keep more lines around than it uses, so their
+     * strings can be reused. See @a insertTileLines.
+     * @exception Chocobun::Exception if an invalid character is passed, or
+     * if the vector holds fewer lines than requested
+     * @param y The Y coordinate for the first line to insert
+     * @param lines The lines of tiles to insert, one after another
+     * @param numLines The number of lines to insert from the start of lines
+     */
+    void insertTileLines( const std::size_t& y, const std::vector<std::string>& lines, const std::size_t& numLines );
+
     /*!
      * @brief Streams all current tile data to a stream object
      * This can be used to retrieve all of the tiles to update
@@ -246,6 +296,7 @@ public:
     /*!
      * @brief Sets the name of the level
      * @note If the level name has already been set, this will overwrite it.
+     * Listeners are notified, so collections can keep their name index up to date.
      */
     void setLevelName( const std::string& name );
 
@@ -269,6 +320,7 @@ public:
      * applied to the level. (see issue #15)
      * Therefore, the undo data is only evaluated and saved here, but still
      * needs to be applied with @a applyUndoData.
+     * The string may be RLE compressed, e.g. "3r2(uL)*l".
      * @exception Chocobun::Exception if the input string is invalid.
      * @param undoData The undo/redo data string
      */
@@ -283,6 +335,17 @@ public:
      */
     void applyUndoData( void );
 
+    /*!
+     * @brief Makes a sequence of moves at once
+     * Listeners are only informed once through LevelListener::onReplaceBoard
+     * instead of for every tile, and no deadlock checks are done. Moves which
+     * aren't possible are skipped. The moves can be undone one by one.
+     * @exception Chocobun::Exception if the level is invalid or the string
+     * contains anything other than LURD characters
+     * @param moves The moves to make, in the same format as undo data
+     */
+    void applyMoves( const std::string& moves );
+
     /*!
      * @brief Validates the level
      *
@@ -297,12 +360,31 @@ public:
      * This method also 'finalises' the level by performing some internal setup on the
      * provided tile data. This includes:
      * - Player x,y coordinates are set
+     * - Dead squares are calculated (see @a isDeadSquare)
      * - Level is reset and undo data is applied
      * @exception If the level is invalid, a Chocobun::Exception is thrown with
      * a detailed description of what went wrong.
      */
     void validateLevel( void );
 
+    /*!
+     * @brief Checks if the level has been successfully validated
+     * @return Returns true if @a validateLevel succeeded, false if otherwise
+     */
+    bool isValid( void ) const;
+
+    /*!
+     * @brief Gets the current x-coordinate of the player
+     * @note Only meaningful once the level has been validated
+     */
+    std::size_t getPlayerX( void ) const;
+
+    /*!
+     * @brief Gets the current y-coordinate of the player
+     * @note Only meaningful once the level has been validated
+     */
+    std::size_t getPlayerY( void ) const;
+
     /*!
      * @brief Moves the player up by one tile
      * @note If the move is not possible, this method will silently fail
@@ -327,15 +409,32 @@ public:
      */
     void moveRight( void );
 
+    /*!
+     * @brief Moves the player without informing listeners or recording undo data
+     *
+     * This is meant for simulations making many moves. Nothing is thrown and
+     * no memory is allocated, except when a board shared with a copy of the
+     * level has to be copied before its first change. Invalid directions and
+     * moves on invalid levels are reported as blocked.
+     * @note Moves made this way can't be undone. @a undo and @a redo return
+     * false until @a reset or @a applyUndoData is called.
+     * @param direction The direction to move the player, can be either
+     * u, d, l, r, or U, D, L, R
+     * @return What the move did
+     */
+    StepResult step( const char& direction );
+
     /*!
      * @brief Undoes the last move
-     * @return Returns false if there is no more undo data, otherwise true is returned
+     * @return Returns false if there is no more undo data, or if the move
+     * doesn't fit the board, otherwise true is returned
      */
     bool undo( void );
 
     /*!
      * @brief Redoes a move
-	 * @return Returns false if there is no more data to redo, otherwise true is returned
+	 * @return Returns false if there is no more data to redo, or if the move
+	 * doesn't fit the board, otherwise true is returned
      */
     bool redo( void );
 
@@ -361,6 +460,121 @@ public:
      */
     bool redoDataExists( void );
 
+    /*!
+     * @brief Gets the moves made on this level, including the ones that can be redone
+     */
+    const UndoHistory& getUndoHistory( void ) const;
+
+    /*!
+     * @brief Sets whether undone moves are kept when making different moves
+     * If enabled, the redo moves are kept as a branch of an undo tree instead
+     * of being erased, and can be switched back to with @a selectRedoBranch.
+     * @note Default is false
+     */
+    void setUndoBranching( const bool& enable );
+
+    /*!
+     * @brief Gets whether undone moves are kept when making different moves
+     */
+    bool getUndoBranching( void ) const;
+
+    /*!
+     * @brief Gets the number of kept redo branches starting at the current move
+     */
+    std::size_t getNumRedoBranches( void ) const;
+
+    /*!
+     * @brief Switches the redo moves to a kept redo branch
+     * The current redo moves are kept as a branch in return. The level itself
+     * doesn't change until @a redo is called.
+     * @exception Chocobun::Exception if the index is out of range
+     * @param index The branch to switch to, lower than @a getNumRedoBranches
+     */
+    void selectRedoBranch( const std::size_t& index );
+
+    /*!
+     * @brief Checks if every box is placed on a goal square
+     * @return Returns true if the level is solved, false if otherwise
+     */
+    bool isSolved( void ) const;
+
+    /*!
+     * @brief Calculates all squares the player can walk to without pushing a box
+     * @param reachable A bitboard to write the reachable squares to. It is
+     * resized to the dimensions of the level.
+     */
+    void getPlayerReachableArea( Bitboard& reachable ) const;
+
+    /*!
+     * @brief Checks if a box on the specified square can never reach a goal
+     * Dead squares are calculated once by @a validateLevel from the walls and
+     * goals of the level, so this is a single lookup.
+     * @note Coordinates outside of the level are never dead
+     */
+    bool isDeadSquare( const std::size_t& x, const std::size_t& y ) const;
+
+    /*!
+     * @brief Gets the bitboard of all dead squares
+     * @see isDeadSquare
+     */
+    const Bitboard& getDeadSquareBoard( void ) const;
+
+    /*!
+     * @brief Sets whether pushes onto dead squares should be refused
+     * When enabled, pushing a box onto a dead square fails silently like
+     * pushing it into a wall would.
+     * @note Default is false
+     */
+    void setRefuseDeadlyPushes( const bool& refuse );
+
+    /*!
+     * @brief Gets whether pushes onto dead squares are refused
+     */
+    bool getRefuseDeadlyPushes( void ) const;
+
+    /*!
+     * @brief Sets whether pushes should be checked for deadlocks
+     * When enabled, every push is checked by a DeadlockDetector and listeners
+     * are informed through LevelListener::onDeadlock if the level can no
+     * longer be solved.
+     * @note Default is false
+     */
+    void setDeadlockDetection( const bool& enable );
+
+    /*!
+     * @brief Gets whether pushes are checked for deadlocks
+     */
+    bool getDeadlockDetection( void ) const;
+
+    /*!
+     * @brief Gets a 64-bit Zobrist hash of the current state
+     *
+     * The hash covers the box positions and the region the player can walk
+     * to, so two states which only differ in where the player stands within
+     * the same region hash to the same value. The box part is updated
+     * incrementally with every tile change. The player region is only
+     * recalculated after a box or wall moved.
+     * @note The level has to be reset at least once before calling this
+     */
+    Uint64 getStateHash( void ) const;
+
+    /*!
+     * @brief Gets the bitboard of all wall squares in the current state
+     * @note The padding border surrounding the level is marked as wall, and
+     * so is floor which can't be reached from the player's starting square
+     */
+    const Bitboard& getWallBoard( void ) const;
+
+    /*!
+     * @brief Gets the bitboard of all goal squares in the current state
+     */
+    const Bitboard& getGoalBoard( void ) const;
+
+    /*!
+     * @brief Gets the bitboard of all box squares in the current state
+     */
+    const Bitboard& getBoxBoard( void ) const;
+
     /*!
      * @brief Registers a level listener
      *
@@ -378,12 +592,33 @@ public:
      */
     void removeListener( LevelListener* listener );
 
+    /*!
+     * @brief Replaces a registered level listener with another one
+     * The new listener takes the place of the old one, so this never
+     * allocates. Nothing happens if the old listener isn't registered.
+     * @param oldListener The listener to replace
+     * @param newListener The listener to register in its place
+     */
+    void replaceListener( LevelListener* oldListener, LevelListener* newListener ) noexcept;
+
     /*!
      * @brief Overload assignment operator
      * Allows copying between level objects
      */
     Level& operator=( const Level& other );
 
+    /*!
+     * @brief Overload move assignment operator
+     * Exchanges the contents of both levels, see @a swap
+     */
+    Level& operator=( Level&& other ) noexcept;
+
+    /*!
+     * @brief Exchanges the contents of two levels without copying them
+     * Boards, meta data, undo history and listeners are all exchanged.
+     */
+    void swap( Level& other ) noexcept;
+
 private:
 
     /*!
@@ -397,12 +632,57 @@ private:
      */
     void movePlayer( char direction, bool updateUndoData = true );
 
+    /*!
+     * @brief Moves the player without informing listeners or recording undo data
+     * @param direction The direction to move the player, same as for @a movePlayer
+     * @param isPushingBox Set to true if a box was pushed
+     * @return Returns true if the player moved, false if the move isn't possible
+     */
+    bool stepPlayer( char direction, bool& isPushingBox );
+
+    /*!
+     * @brief Sets a tile and updates the bitboards without informing listeners
+     * @note No boundary checking is performed. The wall board keeps moves on
+     * the board, see @a updateBitboards
+     */
+    void placeTile( const std::size_t& x, const std::size_t& y, const char& tile );
+
+    /*!
+     * @brief Finds all squares from which a box can't be pushed to any goal
+     */
+    void calculateDeadSquares( void );
+
+    /*!
+     * @brief Rebuilds the wall, goal and box bitboards from the current tile data
+     * This also sets the player position and the state hash. Floor the player
+     * can't get to is added to the wall board.
+     */
+    void updateBitboards( void );
+
+    /*!
+     * @brief Updates the wall, goal and box bitboards for a single tile
+     * This also keeps the state hash up to date.
+     */
+    void updateBitboardTile( const std::size_t& x, const std::size_t& y, const char& tile );
+
     /*!
      * @brief Dispatches the set tile event
      * This occurs whenever a tile is changed
      */
     void dispatchSetTile( const std::size_t& x, const std::size_t& y, const char& tile );
 
+    /*!
+     * @brief Dispatches the replace board event
+     * This occurs whenever many tiles were changed at once
+     */
+    void dispatchReplaceBoard( void );
+
+    /*!
+     * @brief Dispatches the deadlock event
+     * This occurs whenever a push leads to a deadlock
+     */
+    void dispatchDeadlock( const std::size_t& x, const std::size_t& y, const DeadlockDetector::Type& type );
+
     /*!
      * @brief Dispatches the move tile event
      * This occurs whenever a tile moves from an old position to a new
@@ -410,18 +690,98 @@ private:
      */
     void dispatchMoveTile( const std::size_t& oldX, const std::size_t& oldY, const std::size_t& newX, const std::size_t& newY );
 
-    std::map<std::string, std::string>  m_MetaData;
-    LevelArray_t*                       m_LevelArray;
-    LevelArray_t*                       m_InitialLevelArray;
-    std::vector<std::string>            m_HeaderData;
-    std::vector<std::string>            m_Notes;
-    std::vector<char>                   m_UndoData;
+    /*!
+     * @brief Dispatches the set level name event
+     * This occurs whenever the level is renamed
+     */
+    void dispatchSetLevelName( const std::string& oldName );
+
+    /*!
+     * @brief Copies lines of tiles into the initial board
+     * Used by @a insertTileLine and @a insertTileLines. The board is resized
+     * at most once.
+     * @param caller The name of the method to report in exceptions
+     */
+    void copyTileLines( const std::size_t& y, const std::string* lines, const std::size_t& numLines, const char* caller );
+
+    /*!
+     * @brief Text stored with the level in the file
+     * Never changes while the level is being played, so copies of a level
+     * share it until one of them is edited.
+     */
+    struct LevelText
+    {
+        std::map<std::string, std::string>  metaData;
+        std::vector<std::string>            headerData;
+        std::vector<std::string>            notes;
+    };
+
+    /*!
+     * @brief Gets the text all new levels start with
+     * It's shared by all levels until they add text of their own.
+     */
+    static const std::shared_ptr<LevelText>& getEmptyText( void );
+
+    /*!
+     * @brief Gets the board all new levels start with
+     * It's shared by all levels until they insert tiles of their own.
+     */
+    static const std::shared_ptr<LevelArray_t>& getEmptyLevelArray( void );
+
+    /*!
+     * @brief Gets the level text for editing
+     * The text is copied first unless this level owns it.
+     */
+    LevelText& getWritableText( void );
+
+    /*!
+     * @brief Gets the current board for editing
+     * The board is copied first unless this level owns it. It isn't owned
+     * while it's shared with the initial board or with another level.
+     */
+    LevelArray_t& getWritableLevelArray( void );
+
+    /*!
+     * @brief Gets the initial board for editing
+     * The board is copied first unless this level owns it.
+     */
+    LevelArray_t& getWritableInitialLevelArray( void );
+
+    std::shared_ptr<LevelText>          m_Text;
+    std::shared_ptr<LevelArray_t>       m_LevelArray;
+    std::shared_ptr<LevelArray_t>       m_InitialLevelArray;
+
+    // set while the data above is used by this level alone and may be
+    // changed in place. Copying a level clears them on both sides. The
+    // reference counts aren't used for this, because copies of a level
+    // may be handed to other threads.
+    mutable bool                        m_OwnsText;
+    mutable bool                        m_OwnsLevelArray;
+    mutable bool                        m_OwnsInitialLevelArray;
     std::string                         m_LevelName;
     std::vector<LevelListener*>         m_LevelListeners;
 
+    Bitboard                            m_WallBoard;
+    Bitboard                            m_GoalBoard;
+    Bitboard                            m_BoxBoard;
+
     std::size_t                         m_PlayerX;
     std::size_t                         m_PlayerY;
-    std::size_t                         m_UndoDataPos;
+    UndoHistory                         m_UndoHistory;
+
+    // set by step, whose moves aren't in the undo history. Undoing and
+    // redoing are refused until the board matches the history again.
+    bool                                m_HasUnrecordedMoves;
+
+    // state hash, the normalised player is the lowest reachable square
+    Uint64                              m_BoxHash;
+    mutable std::size_t                 m_NormalisedPlayer;
+    mutable bool                        m_IsPlayerRegionDirty;
+
+    Bitboard                            m_DeadSquareBoard;
+    bool                                m_RefuseDeadlyPushes;
+    DeadlockDetector                    m_DeadlockDetector;
+    bool                                m_DetectDeadlocks;
 
     bool                                m_IsLevelValid;
 };
@@ -25,10 +25,18 @@
 // --------------------------------------------------------------
 // include files
 
+#include <core/DeadlockDetector.hpp>
+
 #include <cstddef> // std::size_t
+#include <string>
 
 namespace Chocobun {
 
+// --------------------------------------------------------------
+// forward declarations
+
+class Level;
+
 /*!
  * @brief Listener interface class
  * Allows other objects to register and listen to level events
@@ -47,6 +55,29 @@ public:
      */
     virtual void onMoveTile( const std::size_t& oldX, const std::size_t& oldY, const std::size_t& newX, const std::size_t& newY ){}
 
+    /*!
+     * @brief When many tiles changed at once, for instance after applying undo data
+     * No other events are sent for the changed tiles, so the whole level
+     * should be read again.
+     */
+    virtual void onReplaceBoard( void ){}
+
+    /*!
+     * @brief When a push leaves the level in a state that can no longer be solved
+     * Only dispatched if deadlock detection is enabled on the level.
+     * @param x The x-coordinate of the pushed box
+     * @param y The y-coordinate of the pushed box
+     * @param type The kind of deadlock
+     */
+    virtual void onDeadlock( const std::size_t& x, const std::size_t& y, const DeadlockDetector::Type& type ){}
+
+    /*!
+     * @brief When the name of a level changes
+     * @param level The renamed level, which already has its new name
+     * @param oldName The name the level had before
+     */
+    virtual void onSetLevelName( const Level& level, const std::string& oldName ){}
+
 };
 
 } // namespace Chocobun
@@ -0,0 +1,76 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// LineReader.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/LineReader.hpp>
+
+#include <cstring>
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+LineReader::LineReader( const char* data, const std::size_t& size ) :
+    m_Data( data ),
+    m_Size( size ),
+    m_Offset( 0 ),
+    m_Eof( false )
+{
+}
+
+// --------------------------------------------------------------
+LineReader::~LineReader( void )
+{
+}
+
+// --------------------------------------------------------------
+void LineReader::getLine( StringView& line )
+{
+    const char* begin = m_Data + m_Offset;
+    const char* end = static_cast<const char*>( std::memchr( begin, '\n', m_Size - m_Offset ) );
+
+    // ran into the end of the text
+    if( !end )
+    {
+        line = StringView( begin, m_Size - m_Offset );
+        m_Offset = m_Size;
+        m_Eof = true;
+        return;
+    }
+
+    line = StringView( begin, end - begin );
+    m_Offset = end - m_Data + 1;
+}
+
+// --------------------------------------------------------------
+bool LineReader::eof( void ) const
+{
+    return m_Eof;
+}
+
+// --------------------------------------------------------------
+std::size_t LineReader::getOffset( void ) const
+{
+    return m_Offset;
+}
+
+} // namespace Chocobun
@@ -0,0 +1,85 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// LineReader.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_LINE_READER_HPP__
+#define __CHOCOBUN_CORE_LINE_READER_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+#include <core/StringView.hpp>
+
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Splits a block of text into lines without copying it
+ *
+ * Behaves like calling std::getline on a stream of the text: lines are
+ * split at '\n' only, and @a eof becomes true once a line ran into the end
+ * of the text instead of a '\n'. A text ending in '\n' therefore ends with
+ * an empty line.
+ */
+class LineReader
+{
+public:
+
+    /*!
+     * @brief Constructor
+     * @param data The text to read. Must outlive the reader and all lines.
+     * @param size The number of characters in the text
+     */
+    LineReader( const char* data, const std::size_t& size );
+
+    /*!
+     * @brief Destructor
+     */
+    ~LineReader( void );
+
+    /*!
+     * @brief Reads the next line
+     * @param line Receives the line, without the '\n'
+     */
+    void getLine( StringView& line );
+
+    /*!
+     * @brief Checks if the end of the text was reached
+     */
+    bool eof( void ) const;
+
+    /*!
+     * @brief Gets the offset of the next line to be read
+     */
+    std::size_t getOffset( void ) const;
+
+private:
+
+    const char*     m_Data;
+    std::size_t     m_Size;
+    std::size_t     m_Offset;
+    bool            m_Eof;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_LINE_READER_HPP__
@@ -0,0 +1,157 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// MappedFile.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/MappedFile.hpp>
+#include <core/Exception.hpp>
+
+#if defined(CHOCOBUN_CORE_PLATFORM_WINDOWS)
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+MappedFile::MappedFile( void ) :
+    m_Data( 0 ),
+    m_Size( 0 ),
+    m_IsOpen( false ),
+#if defined(CHOCOBUN_CORE_PLATFORM_WINDOWS)
+    m_File( INVALID_HANDLE_VALUE ),
+    m_Mapping( 0 )
+#else
+    m_File( -1 )
+#endif
+{
+}
+
+// --------------------------------------------------------------
+MappedFile::~MappedFile( void )
+{
+    this->close();
+}
+
+// --------------------------------------------------------------
+void MappedFile::open( const std::string& fileName )
+{
+    this->close();
+
+#if defined(CHOCOBUN_CORE_PLATFORM_WINDOWS)
+    m_File = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+    if( m_File == INVALID_HANDLE_VALUE )
+        throw Exception( "[MappedFile::open] Error: attempt to open file \"" + fileName + "\" failed" );
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( m_File, &size ) )
+    {
+        this->close();
+        throw Exception( "[MappedFile::open] Error: unable to get size of file \"" + fileName + "\"" );
+    }
+    m_Size = static_cast<std::size_t>( size.QuadPart );
+
+    // empty files can't be mapped
+    if( m_Size )
+    {
+        m_Mapping = CreateFileMappingA( m_File, 0, PAGE_READONLY, 0, 0, 0 );
+        if( m_Mapping )
+            m_Data = static_cast<const char*>( MapViewOfFile( m_Mapping, FILE_MAP_READ, 0, 0, 0 ) );
+        if( !m_Data )
+        {
+            this->close();
+            throw Exception( "[MappedFile::open] Error: unable to map file \"" + fileName + "\"" );
+        }
+    }
+#else
+    m_File = ::open( fileName.c_str(), O_RDONLY );
+    if( m_File == -1 )
+        throw Exception( "[MappedFile::open] Error: attempt to open file \"" + fileName + "\" failed" );
+    struct stat info;
+    if( fstat( m_File, &info ) == -1 )
+    {
+        this->close();
+        throw Exception( "[MappedFile::open] Error: unable to get size of file \"" + fileName + "\"" );
+    }
+    m_Size = static_cast<std::size_t>( info.st_size );
+
+    // empty files can't be mapped
+    if( m_Size )
+    {
+        void* data = mmap( 0, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0 );
+        if( data == MAP_FAILED )
+        {
+            this->close();
+            throw Exception( "[MappedFile::open] Error: unable to map file \"" + fileName + "\"" );
+        }
+        m_Data = static_cast<const char*>( data );
+
+        // the file is read from front to back
+        madvise( data, m_Size, MADV_SEQUENTIAL );
+    }
+#endif
+
+    if( !m_Data ) m_Data = "";
+    m_IsOpen = true;
+}
+
+// --------------------------------------------------------------
+void MappedFile::close( void )
+{
+#if defined(CHOCOBUN_CORE_PLATFORM_WINDOWS)
+    if( m_Data && m_Size ) UnmapViewOfFile( m_Data );
+    if( m_Mapping ) CloseHandle( m_Mapping );
+    if( m_File != INVALID_HANDLE_VALUE ) CloseHandle( m_File );
+    m_Mapping = 0;
+    m_File = INVALID_HANDLE_VALUE;
+#else
+    if( m_Data && m_Size ) munmap( const_cast<char*>( m_Data ), m_Size );
+    if( m_File != -1 ) ::close( m_File );
+    m_File = -1;
+#endif
+    m_Data = 0;
+    m_Size = 0;
+    m_IsOpen = false;
+}
+
+// --------------------------------------------------------------
+bool MappedFile::isOpen( void ) const
+{
+    return m_IsOpen;
+}
+
+// --------------------------------------------------------------
+const char* MappedFile::data( void ) const
+{
+    return m_Data;
+}
+
+// --------------------------------------------------------------
+const std::size_t& MappedFile::size( void ) const
+{
+    return m_Size;
+}
+
+} // namespace Chocobun
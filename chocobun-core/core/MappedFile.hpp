@@ -0,0 +1,105 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// MappedFile.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_MAPPED_FILE_HPP__
+#define __CHOCOBUN_CORE_MAPPED_FILE_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <string>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Maps a file into memory for reading
+ *
+ * The contents can be read directly through @a data without copying them
+ * into buffers first. The mapping is read only and stays valid until the
+ * file is closed.
+ */
+class MappedFile
+{
+public:
+
+    /*!
+     * @brief Constructor
+     */
+    MappedFile( void );
+
+    /*!
+     * @brief Destructor
+     * Closes the file if it is open.
+     */
+    ~MappedFile( void );
+
+    /*!
+     * @brief Opens and maps a file
+     * Any previously opened file is closed first.
+     * @exception Chocobun::Exception if the file can't be opened or mapped
+     * @param fileName The name of the file to open
+     */
+    void open( const std::string& fileName );
+
+    /*!
+     * @brief Unmaps and closes the file
+     */
+    void close( void );
+
+    /*!
+     * @brief Checks if a file is open
+     */
+    bool isOpen( void ) const;
+
+    /*!
+     * @brief Gets a pointer to the contents of the file
+     * @note The contents aren't null terminated
+     */
+    const char* data( void ) const;
+
+    /*!
+     * @brief Gets the size of the file in bytes
+     */
+    const std::size_t& size( void ) const;
+
+private:
+
+    // not copyable
+    MappedFile( const MappedFile& );
+    MappedFile& operator=( const MappedFile& );
+
+    const char*     m_Data;
+    std::size_t     m_Size;
+    bool            m_IsOpen;
+#if defined(CHOCOBUN_CORE_PLATFORM_WINDOWS)
+    void*           m_File;
+    void*           m_Mapping;
+#else
+    int             m_File;
+#endif
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_MAPPED_FILE_HPP__
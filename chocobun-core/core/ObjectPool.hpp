@@ -0,0 +1,154 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// ObjectPool.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_OBJECT_POOL_HPP__
+#define __CHOCOBUN_CORE_OBJECT_POOL_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/ObjectPool.hxx>
+
+#include <new>
+#include <utility> // std::swap
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// the number of objects in the first block, and the most objects a block
+// may hold
+static const std::size_t OBJECT_POOL_FIRST_BLOCK_SIZE = 16;
+static const std::size_t OBJECT_POOL_MAX_BLOCK_SIZE = 1024;
+
+// --------------------------------------------------------------
+template <class T>
+ObjectPool<T>::ObjectPool( void ) :
+    m_Next( 0 ),
+    m_NumRemaining( 0 ),
+    m_BlockSize( OBJECT_POOL_FIRST_BLOCK_SIZE )
+{
+}
+
+// --------------------------------------------------------------
+template <class T>
+ObjectPool<T>::~ObjectPool( void )
+{
+    this->clear();
+}
+
+// --------------------------------------------------------------
+template <class T>
+void ObjectPool<T>::swap( ObjectPool& that ) noexcept
+{
+    m_Blocks.swap( that.m_Blocks );
+    m_FreeSlots.swap( that.m_FreeSlots );
+    std::swap( m_Next, that.m_Next );
+    std::swap( m_NumRemaining, that.m_NumRemaining );
+    std::swap( m_BlockSize, that.m_BlockSize );
+}
+
+// --------------------------------------------------------------
+template <class T>
+T* ObjectPool<T>::construct( void )
+{
+    void* slot = this->allocate();
+    try
+    {
+        return new(slot) T();
+    }
+    catch( ... )
+    {
+        m_FreeSlots.push_back( slot );
+        throw;
+    }
+}
+
+// --------------------------------------------------------------
+template <class T>
+T* ObjectPool<T>::construct( const T& that )
+{
+    void* slot = this->allocate();
+    try
+    {
+        return new(slot) T( that );
+    }
+    catch( ... )
+    {
+        m_FreeSlots.push_back( slot );
+        throw;
+    }
+}
+
+// --------------------------------------------------------------
+template <class T>
+void ObjectPool<T>::destroy( T* object )
+{
+    object->~T();
+    m_FreeSlots.push_back( object );
+}
+
+// --------------------------------------------------------------
+template <class T>
+void ObjectPool<T>::clear( void )
+{
+    for( typename std::vector<char*>::iterator it = m_Blocks.begin(); it != m_Blocks.end(); ++it )
+        ::operator delete( *it );
+    m_Blocks.clear();
+    m_FreeSlots.clear();
+    m_Next = 0;
+    m_NumRemaining = 0;
+    m_BlockSize = OBJECT_POOL_FIRST_BLOCK_SIZE;
+}
+
+// --------------------------------------------------------------
+template <class T>
+void* ObjectPool<T>::allocate( void )
+{
+
+    // reuse memory of destroyed objects first
+    if( !m_FreeSlots.empty() )
+    {
+        void* slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        return slot;
+    }
+
+    // operator new aligns the block for any type, and every slot keeps
+    // that alignment as sizeof(T) is a multiple of the alignment of T
+    if( !m_NumRemaining )
+    {
+        m_Blocks.reserve( m_Blocks.size()+1 );
+        m_Next = static_cast<char*>( ::operator new( m_BlockSize * sizeof(T) ) );
+        m_Blocks.push_back( m_Next );
+        m_NumRemaining = m_BlockSize;
+        if( m_BlockSize < OBJECT_POOL_MAX_BLOCK_SIZE )
+            m_BlockSize *= 2;
+    }
+
+    void* slot = m_Next;
+    m_Next += sizeof(T);
+    --m_NumRemaining;
+    return slot;
+}
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_OBJECT_POOL_HPP__
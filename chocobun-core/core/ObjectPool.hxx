@@ -0,0 +1,108 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// ObjectPool.hxx
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_OBJECT_POOL_HXX__
+#define __CHOCOBUN_CORE_OBJECT_POOL_HXX__
+
+// --------------------------------------------------------------
+// include files
+
+#include <vector>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Allocates objects of the same type from a few large blocks
+ *
+ * Each block holds twice as many objects as the previous one, up to a
+ * limit, so creating many objects only requires a handful of allocations.
+ * The memory of destroyed objects is reused by the next objects created.
+ * All blocks are released at once when the pool is cleared or destroyed.
+ */
+template <class T>
+class ObjectPool
+{
+public:
+
+    /*!
+     * @brief Constructor
+     */
+    ObjectPool( void );
+
+    /*!
+     * @brief Destructor
+     * Releases all blocks. All objects must have been destroyed already.
+     */
+    ~ObjectPool( void );
+
+    /*!
+     * @brief Exchanges the blocks of two pools
+     * Objects stay where they are, they just belong to the other pool afterwards.
+     */
+    void swap( ObjectPool& that ) noexcept;
+
+    /*!
+     * @brief Default constructs a new object in the pool
+     */
+    T* construct( void );
+
+    /*!
+     * @brief Copy constructs a new object in the pool
+     * @param that The object to copy
+     */
+    T* construct( const T& that );
+
+    /*!
+     * @brief Destroys an object previously constructed by this pool
+     * Its memory is reused by the next object constructed.
+     * @param object The object to destroy
+     */
+    void destroy( T* object );
+
+    /*!
+     * @brief Releases all blocks
+     * @note All objects must have been destroyed already, as their
+     * destructors aren't called.
+     */
+    void clear( void );
+
+private:
+
+    // not copyable
+    ObjectPool( const ObjectPool& );
+    ObjectPool& operator=( const ObjectPool& );
+
+    /*!
+     * @brief Gets memory for one object, allocating a new block if necessary
+     */
+    void* allocate( void );
+
+    std::vector<char*>  m_Blocks;
+    std::vector<void*>  m_FreeSlots;
+    char*               m_Next;
+    std::size_t         m_NumRemaining;
+    std::size_t         m_BlockSize;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_OBJECT_POOL_HXX__
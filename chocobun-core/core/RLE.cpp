@@ -23,13 +23,179 @@
 // include files
 
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include <core/RLE.hpp>
 #include <core/Config.hpp>
+#include <core/Exception.hpp>
 
 namespace Chocobun {
 
+namespace {
+
+// how many characters a group may be moved or shortened by to fit in with
+// its neighbours
+const size_t MAX_SHIFT = 32;
+
 // --------------------------------------------------------------
-RLE::RLE( void )
+// Polynomial hashes of all prefixes of a string, so any two substrings can
+// be compared in constant time. Two moduli make collisions unlikely.
+class PrefixHash
+{
+public:
+
+    PrefixHash( const char* data, const size_t& size ) :
+        m_Data( data ),
+        m_Hash1( size+1, 0 ),
+        m_Hash2( size+1, 0 ),
+        m_Pow1( size+1, 1 ),
+        m_Pow2( size+1, 1 )
+    {
+        for( size_t i = 0; i != size; ++i )
+        {
+            Uint64 chr = static_cast<Uint8>( data[i] ) + 1;
+            m_Hash1[i+1] = ( m_Hash1[i] * BASE + chr ) % MOD1;
+            m_Hash2[i+1] = ( m_Hash2[i] * BASE + chr ) % MOD2;
+            m_Pow1[i+1] = m_Pow1[i] * BASE % MOD1;
+            m_Pow2[i+1] = m_Pow2[i] * BASE % MOD2;
+        }
+    }
+
+    // compares the substrings of the given length starting at a and b
+    bool equals( const size_t& a, const size_t& b, const size_t& length ) const
+    {
+        return get( m_Hash1, m_Pow1, MOD1, a, length ) == get( m_Hash1, m_Pow1, MOD1, b, length ) &&
+               get( m_Hash2, m_Pow2, MOD2, a, length ) == get( m_Hash2, m_Pow2, MOD2, b, length );
+    }
+
+    // number of equal characters starting at a and b, at most limit
+    size_t matchForward( const size_t& a, const size_t& b, const size_t& limit ) const
+    {
+        if( !limit || m_Data[a] != m_Data[b] ) return 0;
+        size_t low = 1, high = limit;
+        while( low < high )
+        {
+            size_t mid = high - (high - low) / 2;
+            if( this->equals( a, b, mid ) ) low = mid; else high = mid - 1;
+        }
+        return low;
+    }
+
+    // number of equal characters ending right before a and b, at most limit
+    size_t matchBackward( const size_t& a, const size_t& b, const size_t& limit ) const
+    {
+        if( !limit || m_Data[a-1] != m_Data[b-1] ) return 0;
+        size_t low = 1, high = limit;
+        while( low < high )
+        {
+            size_t mid = high - (high - low) / 2;
+            if( this->equals( a-mid, b-mid, mid ) ) low = mid; else high = mid - 1;
+        }
+        return low;
+    }
+
+    // checks if the substring isn't a repetition of a shorter string
+    bool isPrimitive( const size_t& begin, const size_t& length ) const
+    {
+        for( size_t divisor = 1; divisor*divisor <= length; ++divisor )
+        {
+            if( length % divisor ) continue;
+            if( divisor != length && this->equals( begin, begin+divisor, length-divisor ) ) return false;
+            size_t other = length / divisor;
+            if( other != length && this->equals( begin, begin+other, length-other ) ) return false;
+        }
+        return true;
+    }
+
+private:
+
+    static Uint64 get( const std::vector<Uint64>& hash, const std::vector<Uint64>& pow, Uint64 mod, const size_t& begin, const size_t& length )
+    {
+        return ( hash[begin+length] + mod - hash[begin] * pow[length] % mod ) % mod;
+    }
+
+    static const Uint64 BASE = 131;
+    static const Uint64 MOD1 = 1000000007;
+    static const Uint64 MOD2 = 998244353;
+
+    const char* m_Data;
+    std::vector<Uint64> m_Hash1;
+    std::vector<Uint64> m_Hash2;
+    std::vector<Uint64> m_Pow1;
+    std::vector<Uint64> m_Pow2;
+};
+
+// --------------------------------------------------------------
+// a substring consisting of at least two repetitions of a period
+struct Run
+{
+    size_t begin;
+    size_t end;
+    size_t period;
+    std::vector<const std::string*> inner; // the compressed period for each rotation
+};
+
+// --------------------------------------------------------------
+// a group being decompressed, which has been opened but not closed yet
+struct OpenGroup
+{
+    size_t begin; // where the group begins in the output
+    size_t count;
+};
+
+// --------------------------------------------------------------
+// repeats everything written since the group was opened
+void closeGroup( const OpenGroup& group, const size_t& base, const size_t& maxSize, size_t& total, std::string* output )
+{
+    size_t length = total - group.begin;
+    if( group.count && length > (maxSize - group.begin) / group.count )
+        throw Exception( "[RLE::decompress] Error: data expands to more than the maximum decompressed size" );
+    total = group.begin + length * group.count;
+    if( !output ) return;
+
+    // the repeated part doubles with every copy
+    output->resize( std::min( output->size(), base + total ) );
+    while( output->size() < base + total )
+    {
+        size_t written = output->size() - base - group.begin;
+        output->append( *output, base + group.begin, std::min( written, base + total - output->size() ) );
+    }
+}
+
+// --------------------------------------------------------------
+// characters which have a meaning in compressed data
+bool isControlCharacter( const char& chr )
+{
+    return ( chr > 47 && chr < 58 ) || chr == '(' || chr == ')';
+}
+
+// --------------------------------------------------------------
+size_t numDigits( size_t number )
+{
+    size_t digits = 1;
+    while( number >= 10 )
+    {
+        number /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+// --------------------------------------------------------------
+// the smallest number of repetitions a group is tried with, so the group
+// following it can start up to MAX_SHIFT characters earlier
+size_t getMinCount( const size_t& maxCount, const size_t& period )
+{
+    size_t shift = std::max<size_t>( 1, MAX_SHIFT / period );
+    return ( maxCount > shift+2 ? maxCount - shift : 2 );
+}
+
+} // anonymous namespace
+
+// --------------------------------------------------------------
+RLE::RLE( void ) :
+    m_MaxDecompressedSize( 16777216 )
 {
 }
 
@@ -68,122 +234,256 @@ void RLE::compress( std::string& str )
 // --------------------------------------------------------------
 void RLE::multiPassCompress( std::string& str )
 {
+    std::string compressed;
+    this->compressRange( str.data(), str.size(), compressed );
+    m_CompressedSections.clear();
+    str.swap( compressed );
+}
 
-    // the same compression algorithm is performed twice,
-    // one time factoring from the outside in and the other
-    // time factoring from the inside out. The two are compared
-    // and the best result is returned.
-    std::string cp;
-    std::string method1( str );
-    std::string method2;
+// --------------------------------------------------------------
+const std::string& RLE::compressSection( const char* data, const size_t& size )
+{
 
-    // the compare size is the number of characters to compare with the
-    // rest of the string to find matching patterns
-    // NOTE: A "ping-pong" pattern has been implemented to avoid
-    // useless copying of string objects between each other
-    for( size_t compareSize = 1; compareSize < str.size()/2; ++compareSize )
-    {
-        cp.clear();
-        this->multPassCompress_pass( compareSize, method1, cp ); ++compareSize;
-        method1.clear();
-        this->multPassCompress_pass( compareSize, cp, method1 );
-    }
-    for( size_t compareSize = str.size()/2; compareSize > 0; --compareSize )
-    {
-        method2.clear();
-        this->multPassCompress_pass( compareSize, str, method2 );
-        if(!(--compareSize))
-        {
-            str = method2;
-            break;
-        }
-        str.clear();
-        this->multPassCompress_pass( compareSize, method2, str );
-    }
+    // periodic data contains the same sections over and over again, each of
+    // which only has to be compressed once
+    std::string section( data, size );
+    std::unordered_map<std::string, std::string>::iterator it = m_CompressedSections.find( section );
+    if( it != m_CompressedSections.end() )
+        return it->second;
 
-    // compare length to determine which one was more successful
-    if( method1.size() < str.size() ) str = method1;
+    std::string compressed;
+    this->compressRange( data, size, compressed );
+    return m_CompressedSections[section] = compressed;
 }
 
 // --------------------------------------------------------------
-void RLE::multPassCompress_pass( const size_t& compareSize, std::string& input, std::string& output )
+void RLE::compressRange( const char* data, const size_t& size, std::string& output )
 {
 
-    // loops through all characters in the string witha step size
-    // of the compare size
-    size_t pos = 0;
-    while( pos < input.size() )
+    // find the end of the repeated character at every position
+    std::vector<size_t> charRunEnd( size, 0 );
+    for( size_t pos = size; pos-- != 0; )
+        charRunEnd[pos] = ( pos+1 != size && data[pos] == data[pos+1] ? charRunEnd[pos+1] : pos+1 );
+
+    // find all runs, i.e. maximal substrings consisting of at least two
+    // repetitions of a longer period. A run contains two positions which are
+    // a multiple of its period and one period apart, so only these positions
+    // have to be extended into runs.
+    PrefixHash hash( data, size );
+    std::vector<Run> runs;
+    std::vector< std::pair<size_t,size_t> > starts;
+    for( size_t period = 2; period <= size/2; ++period )
     {
+        for( size_t pos = period; pos + period <= size; pos += period )
+        {
+            size_t forward = hash.matchForward( pos, pos+period, size-pos-period );
+            size_t backward = hash.matchBackward( pos, pos+period, pos );
+            if( forward + backward < period ) continue;
+
+            // the hashes only tell that the run probably exists
+            size_t begin = pos - backward;
+            size_t end = pos + period + forward;
+            if( std::memcmp( data + begin, data + begin + period, end - begin - period ) ) continue;
 
-        // the compare string
-        std::string compare = input.substr( pos, compareSize );
+            // every position of a run finds the same run, and the next run
+            // of this period overlaps it by less than one period
+            while( pos + 2*period <= end ) pos += period;
 
-        // loops until the compare pattern doesn't repeat any more
-        size_t pos2 = pos+compareSize;
-        while( pos2 < input.size() && input.substr(pos2, compareSize).compare(compare) == 0 ) pos2 += compareSize;
+            // runs of repeated shorter periods are found with those periods
+            if( !hash.isPrimitive( begin, period ) ) continue;
 
-        // if a pattern was found, apply RLE formatting
-        if( pos2 != pos+compareSize )
+            // a group can start further into the run, so whatever comes
+            // before the run can be merged with its end. Long periods are
+            // only grouped from the start of the run, as each rotation of the
+            // period has to be compressed again.
+            size_t numStarts = std::min( end - begin - 2*period + 1, period + MAX_SHIFT );
+            if( period > MAX_SHIFT ) numStarts = 1;
+            runs.push_back( Run() );
+            Run& run = runs.back();
+            run.begin = begin;
+            run.end = end;
+            run.period = period;
+            run.inner.resize( std::min( numStarts, period ) );
+            for( size_t i = 0; i != run.inner.size(); ++i )
+                run.inner[i] = &this->compressSection( data + begin + i, period );
+            for( size_t i = 0; i != numStarts; ++i )
+                starts.push_back( std::make_pair( begin + i, runs.size()-1 ) );
+        }
+    }
+    std::sort( starts.begin(), starts.end() );
+
+    // find the shortest encoding of every suffix, from back to front. Each
+    // character is either written as it is or starts a group, repeating
+    // either the character or a run's period.
+    const size_t charGroup = runs.size();
+    std::vector<size_t> length( size+1, 0 );
+    std::vector<size_t> chosenCount( size, 0 );
+    std::vector<size_t> chosenRun( size, charGroup );
+    size_t next = starts.size();
+    for( size_t pos = size; pos-- != 0; )
+    {
+        length[pos] = length[pos+1] + 1;
+
+        size_t maxCount = charRunEnd[pos] - pos;
+        for( size_t count = maxCount; count >= getMinCount( maxCount, 1 ); --count )
         {
-            std::stringstream ss;
-            ss << ((pos2-pos) / compareSize);
-            output.append( ss.str() );
-            if( compareSize != 1 )
+            size_t groupLength = numDigits( count ) + 1 + length[pos+count];
+            if( groupLength < length[pos] )
             {
-                output.push_back( '(' );
-                output.append( compare );
-                output.push_back( ')' );
-            }else
-                output.append( compare );
+                length[pos] = groupLength;
+                chosenCount[pos] = count;
+                chosenRun[pos] = charGroup;
+            }
         }
 
-        // if no pattern was found, simply append the compare pattern
-        else
-            output.append( compare );
+        for( ; next != 0 && starts[next-1].first == pos; --next )
+        {
+            const Run& run = runs[starts[next-1].second];
+            const std::string& inner = *run.inner[(pos - run.begin) % run.period];
+            maxCount = ( run.end - pos ) / run.period;
+            for( size_t count = maxCount; count >= getMinCount( maxCount, run.period ); --count )
+            {
+                size_t groupLength = numDigits( count ) + inner.size() + 2 + length[pos + count*run.period];
+                if( groupLength < length[pos] )
+                {
+                    length[pos] = groupLength;
+                    chosenCount[pos] = count;
+                    chosenRun[pos] = starts[next-1].second;
+                }
+            }
+        }
+    }
 
-        pos = pos2;
+    // write the chosen encoding
+    output.reserve( output.size() + length[0] );
+    for( size_t pos = 0; pos < size; )
+    {
+        if( !chosenCount[pos] )
+        {
+            output.push_back( data[pos++] );
+            continue;
+        }
+        std::stringstream ss;
+        ss << chosenCount[pos];
+        output.append( ss.str() );
+        if( chosenRun[pos] == charGroup )
+        {
+            output.push_back( data[pos] );
+            pos += chosenCount[pos];
+            continue;
+        }
+        const Run& run = runs[chosenRun[pos]];
+        output.push_back( '(' );
+        output.append( *run.inner[(pos - run.begin) % run.period] );
+        output.push_back( ')' );
+        pos += chosenCount[pos] * run.period;
     }
 }
 
 // --------------------------------------------------------------
-size_t RLE::decompress( std::string& str )
+void RLE::decompress( std::string& str )
 {
-    std::string ret("");
-    size_t pos = 0;
-    while( pos < str.size() )
+    std::string output;
+    this->decompress( str.data(), str.size(), output );
+    str.swap( output );
+}
+
+// --------------------------------------------------------------
+void RLE::decompress( const char* data, const size_t& size, std::string& output )
+{
+
+    // most lines aren't compressed at all
+    const char* end = data + size;
+    if( std::find_if( data, end, isControlCharacter ) == end )
     {
+        output.append( data, size );
+        return;
+    }
+
+    output.reserve( output.size() + this->getDecompressedSize( data, size ) );
+    this->expand( data, size, &output );
+}
+
+// --------------------------------------------------------------
+size_t RLE::getDecompressedSize( const char* data, const size_t& size ) const
+{
+    return this->expand( data, size, 0 );
+}
 
-        // closing parenthesis
-        if( str[pos] == ')' ) break;
+// --------------------------------------------------------------
+void RLE::setMaxDecompressedSize( const size_t& size )
+{
+    m_MaxDecompressedSize = size;
+}
+
+// --------------------------------------------------------------
+const size_t& RLE::getMaxDecompressedSize( void ) const
+{
+    return m_MaxDecompressedSize;
+}
+
+// --------------------------------------------------------------
+size_t RLE::expand( const char* data, const size_t& size, std::string* output ) const
+{
+
+    // groups which have been opened but not closed yet, with the size of the
+    // output where they begin
+    std::vector<OpenGroup> groups;
+    const size_t base = ( output ? output->size() : 0 );
+    size_t total = 0;
+    size_t count = 0;
+    bool hasCount = false;
+    for( size_t pos = 0; pos != size; ++pos )
+    {
+        const char& chr = data[pos];
 
         // get expansion
-        Chocobun::Int32 expansionCount = 0, digit = 1;
-        while( str[pos] > 47 && str[pos] < 58 )
+        if( chr > 47 && chr < 58 )
         {
-            expansionCount *= digit;
-            expansionCount += static_cast<Chocobun::Int32>( str[pos]-48 );
-            digit *= 10;
-            ++pos;
+            size_t digit = static_cast<size_t>( chr-48 );
+            if( count > (m_MaxDecompressedSize - digit) / 10 )
+                throw Exception( "[RLE::decompress] Error: expansion count exceeds the maximum decompressed size" );
+            count = count*10 + digit;
+            hasCount = true;
+            continue;
         }
-        if( digit == 1 ) expansionCount = 1;
+        const size_t expansionCount = ( hasCount ? count : 1 );
+        count = 0;
+        hasCount = false;
 
-        // get string to expand
-        std::string expansionString = "";
-        if( str[pos] == '(' )
+        // opening parenthesis
+        if( chr == '(' )
         {
-            expansionString = str.substr(pos+1); // +1 to skip opening parenthesis
-            pos += decompress( expansionString );
+            groups.push_back( OpenGroup() );
+            groups.back().begin = total;
+            groups.back().count = expansionCount;
+            continue;
         }
-        else
-            expansionString.push_back( str[pos] );
 
-        // expand
-        for( Chocobun::Int32 i = 0; i != expansionCount; ++i )
-            ret.append( expansionString );
-        ++pos;
+        // closing parenthesis, stray ones are ignored
+        if( chr == ')' )
+        {
+            if( groups.empty() ) continue;
+            closeGroup( groups.back(), base, m_MaxDecompressedSize, total, output );
+            groups.pop_back();
+            continue;
+        }
+
+        // expand single character
+        if( expansionCount > m_MaxDecompressedSize - total )
+            throw Exception( "[RLE::decompress] Error: data expands to more than the maximum decompressed size" );
+        total += expansionCount;
+        if( output ) output->append( expansionCount, chr );
     }
-    str = ret;
-    return pos+1; // +1 to skip closing parenthesis
+
+    // groups left open end with the data
+    while( !groups.empty() )
+    {
+        closeGroup( groups.back(), base, m_MaxDecompressedSize, total, output );
+        groups.pop_back();
+    }
+
+    return total;
 }
 
 } // namespace Chocobun
@@ -22,6 +22,7 @@
 // include files
 
 #include <string>
+#include <unordered_map>
 
 namespace Chocobun {
 
@@ -47,8 +48,8 @@ namespace Chocobun {
  * becomes:
  * @code 4#2$4#2$4#2$4#2$ @endcode
  *
- * <b>Multi-pass Compression</b> performs as many passes as is required
- * to fully factor the string as far as possible. For example:
+ * <b>Multi-pass Compression</b> factors out repeated sections of any
+ * length, nesting them as far as possible. For example:
  * @code ####$$####$$####$$####$$ @endcode
  * becomes:
  * @code 4(4#2$) @endcode
@@ -83,12 +84,16 @@ public:
     /*!
      * @brief Multi-pass RLE compression using parenthesis
      *
-     * Performs as many passes as is required to fully factor the string
-     * as far as possible. For example:
+     * Factors out repeated sections of any length, nesting them as far as
+     * possible. For example:
      * @code ####$$####$$####$$####$$ @endcode
      * becomes:
      * @code 4(4#2$) @endcode
      *
+     * All repeated sections of the string are found with hashed substring
+     * comparisons, and the shortest combination of them is chosen. This
+     * takes close to linear time instead of one pass per section length.
+     *
      * @param str The string to compress
      */
     void multiPassCompress( std::string& str );
@@ -96,26 +101,94 @@ public:
     /*!
      * @brief RLE Decompression
      * @note Supports multi-pass and standard compression
+     * @exception Chocobun::Exception if the string expands to more than the
+     * maximum decompressed size
      *
      * @param str The string to decompress
-     * @return Returns a size_t position relative to the string's beginning
-     * where the last refactor occurred. You may ignore this and simply call
-     * the method without catching the return value; it's used internally.
      */
-    size_t decompress( std::string& str );
+    void decompress( std::string& str );
+
+    /*!
+     * @brief RLE Decompression into an existing string
+     *
+     * The decompressed size is computed first, so the output only has to
+     * be allocated once. Groups are decoded without recursion and without
+     * copying the remaining input.
+     *
+     * @exception Chocobun::Exception if the data expands to more than the
+     * maximum decompressed size
+     *
+     * @param data The compressed data
+     * @param size The length of the compressed data
+     * @param output The decompressed data is appended to this string
+     */
+    void decompress( const char* data, const size_t& size, std::string& output );
+
+    /*!
+     * @brief Computes the length of compressed data once decompressed
+     * @exception Chocobun::Exception if the data expands to more than the
+     * maximum decompressed size
+     *
+     * @param data The compressed data
+     * @param size The length of the compressed data
+     * @return The number of characters the data expands to
+     */
+    size_t getDecompressedSize( const char* data, const size_t& size ) const;
+
+    /*!
+     * @brief Sets the maximum number of characters data may expand to
+     * This protects against huge counts in corrupted or malicious files.
+     * The default is 16777216 characters.
+     *
+     * @param size The maximum decompressed size
+     */
+    void setMaxDecompressedSize( const size_t& size );
+
+    /*!
+     * @brief Gets the maximum number of characters data may expand to
+     */
+    const size_t& getMaxDecompressedSize( void ) const;
 
 private:
 
     /*!
-     * @brief Passes an entire string, factoring out sections with the length of compareSize
+     * @brief Decodes compressed data
+     *
+     * @param data The compressed data
+     * @param size The length of the compressed data
+     * @param output The decompressed data is appended to this string. Pass
+     * 0 to only compute the decompressed size.
+     * @return The number of characters the data expands to
+     *
+     * @note This is used internally by the decompression methods
+     */
+    size_t expand( const char* data, const size_t& size, std::string* output ) const;
+
+    /*!
+     * @brief Compresses a section of a string, nesting repeated sections
      *
-     * @param compareSize The length of the sections to factor out
-     * @param input The input string
-     * @param output The output string
+     * @param data The beginning of the section
+     * @param size The length of the section
+     * @param output The compressed section is appended to this string
      *
      * @note This is used internally by the multi-pass compression method
      */
-    void multPassCompress_pass( const size_t& compareSize, std::string& input, std::string& output );
+    void compressRange( const char* data, const size_t& size, std::string& output );
+
+    /*!
+     * @brief Compresses a section of a string, unless the same section was
+     * compressed before
+     *
+     * @param data The beginning of the section
+     * @param size The length of the section
+     * @return The compressed section
+     *
+     * @note This is used internally by the multi-pass compression method
+     */
+    const std::string& compressSection( const char* data, const size_t& size );
+
+    size_t m_MaxDecompressedSize;
+    std::unordered_map<std::string, std::string> m_CompressedSections;
 };
 
 } // namespace Chocobun
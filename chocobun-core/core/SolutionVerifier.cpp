@@ -0,0 +1,192 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// SolutionVerifier.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/SolutionVerifier.hpp>
+#include <core/Collection.hpp>
+#include <core/Level.hpp>
+#include <core/Bitboard.hpp>
+#include <core/UndoHistory.hpp>
+#include <core/Exception.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+SolutionVerifier::SolutionVerifier( void ) :
+    m_NumThreads( 0 ),
+    m_ElapsedTime( 0.0 )
+{
+}
+
+// --------------------------------------------------------------
+SolutionVerifier::~SolutionVerifier( void )
+{
+}
+
+// --------------------------------------------------------------
+void SolutionVerifier::setNumThreads( const std::size_t& numThreads )
+{
+    m_NumThreads = numThreads;
+}
+
+// --------------------------------------------------------------
+const std::size_t& SolutionVerifier::getNumThreads( void ) const
+{
+    return m_NumThreads;
+}
+
+// --------------------------------------------------------------
+void SolutionVerifier::verify( Collection& collection )
+{
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // look the levels up once, the workers only read them
+    std::vector<std::string> levelNames;
+    collection.getLevelNames( levelNames );
+    std::vector<const Level*> levels;
+    levels.reserve( levelNames.size() );
+    for( std::vector<std::string>::iterator it = levelNames.begin(); it != levelNames.end(); ++it )
+        levels.push_back( &collection.getLevel( *it ) );
+    m_Results.assign( levels.size(), Result() );
+
+    // each worker takes the next level until there are none left
+    std::atomic<std::size_t> nextLevel( 0 );
+    std::vector<Result>& results = m_Results;
+    auto worker = [&]()
+    {
+        for( std::size_t i = nextLevel.fetch_add(1); i < levels.size(); i = nextLevel.fetch_add(1) )
+        {
+            results[i].levelName = levelNames[i];
+            verifyLevel( *levels[i], results[i] );
+        }
+    };
+
+    std::size_t numThreads = m_NumThreads;
+    if( !numThreads ) numThreads = std::thread::hardware_concurrency();
+    if( !numThreads ) numThreads = 1;
+    if( numThreads > levels.size() ) numThreads = levels.size();
+    std::vector<std::thread> threads;
+    for( std::size_t i = 1; i < numThreads; ++i )
+        threads.push_back( std::thread( worker ) );
+    worker();
+    for( std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it )
+        it->join();
+
+    m_ElapsedTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+// --------------------------------------------------------------
+const std::vector<SolutionVerifier::Result>& SolutionVerifier::getResults( void ) const
+{
+    return m_Results;
+}
+
+// --------------------------------------------------------------
+std::size_t SolutionVerifier::getNumSolved( void ) const
+{
+    std::size_t numSolved = 0;
+    for( std::vector<Result>::const_iterator it = m_Results.begin(); it != m_Results.end(); ++it )
+        if( it->isSolved ) ++numSolved;
+    return numSolved;
+}
+
+// --------------------------------------------------------------
+const double& SolutionVerifier::getElapsedTime( void ) const
+{
+    return m_ElapsedTime;
+}
+
+// --------------------------------------------------------------
+double SolutionVerifier::getLevelsPerSecond( void ) const
+{
+    if( m_ElapsedTime <= 0.0 ) return 0.0;
+    return static_cast<double>( m_Results.size() ) / m_ElapsedTime;
+}
+
+// --------------------------------------------------------------
+void SolutionVerifier::verifyLevel( const Level& level, Result& result )
+{
+    result.isValid = false;
+    result.isLegal = false;
+    result.isSolved = false;
+    result.numMoves = 0;
+    result.numPushes = 0;
+
+    // get the initial state from a private copy, so the level keeps its
+    // current position
+    Bitboard walls, goals, boxes;
+    std::size_t player;
+    try
+    {
+        Level copy( level );
+        copy.validateLevel();
+        copy.reset();
+        walls = copy.getWallBoard();
+        goals = copy.getGoalBoard();
+        boxes = copy.getBoxBoard();
+        player = walls.index( copy.getPlayerX(), copy.getPlayerY() );
+    }
+    catch( const Exception& )
+    {
+        return;
+    }
+    result.isValid = true;
+
+    // replay the moves made so far
+    const UndoHistory& history = level.getUndoHistory();
+    for( std::size_t i = 0; i != history.getPosition(); ++i )
+    {
+        char move = history.at(i);
+        bool claimsPush = ( move < 'a' );
+        if( claimsPush ) move += 32;
+        std::size_t delta = 0;
+        if( move == 'u' ) delta = static_cast<std::size_t>(0)-walls.stride();
+        if( move == 'd' ) delta = walls.stride();
+        if( move == 'l' ) delta = static_cast<std::size_t>(0)-1;
+        if( move == 'r' ) delta = 1;
+
+        std::size_t target = player + delta;
+        if( walls.test(target) ) return;
+        bool isPush = boxes.test(target);
+        if( isPush != claimsPush ) return;
+        if( isPush )
+        {
+            std::size_t next = target + delta;
+            if( walls.test(next) || boxes.test(next) ) return;
+            boxes.reset( target );
+            boxes.set( next );
+            ++result.numPushes;
+        }
+        player = target;
+        ++result.numMoves;
+    }
+
+    result.isLegal = true;
+    result.isSolved = boxes.isSubsetOf( goals );
+}
+
+} // namespace Chocobun
@@ -0,0 +1,138 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// SolutionVerifier.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_SOLUTION_VERIFIER_HPP__
+#define __CHOCOBUN_CORE_SOLUTION_VERIFIER_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// forward declarations
+
+class Collection;
+class Level;
+
+/*!
+ * @brief Checks which levels of a collection are solved by their snapshots
+ *
+ * Every level is replayed from its initial state up to the current position
+ * of its undo data, on a private copy of the level. The levels of the
+ * collection itself are left untouched. Levels are spread across several
+ * threads.
+ *
+ * Moves are checked strictly: a move into a wall or a blocked box, or a
+ * move whose case doesn't match whether it pushes a box, makes the
+ * snapshot illegal.
+ */
+class SolutionVerifier
+{
+public:
+
+    /*!
+     * @brief The outcome of verifying a single level
+     */
+    struct Result
+    {
+        std::string levelName;
+        bool        isValid;        //!< False if the level itself couldn't be validated
+        bool        isLegal;        //!< False if a move of the snapshot wasn't possible
+        bool        isSolved;       //!< True if every box ends up on a goal
+        std::size_t numMoves;       //!< Moves made until the end, or until the first illegal move
+        std::size_t numPushes;      //!< Pushes among those moves
+    };
+
+    /*!
+     * @brief Constructor
+     */
+    SolutionVerifier( void );
+
+    /*!
+     * @brief Destructor
+     */
+    ~SolutionVerifier( void );
+
+    /*!
+     * @brief Sets the number of threads to verify with
+     * @note Default is 0
+     * @param numThreads The number of threads. Set to 0 to use one thread
+     * per hardware core.
+     */
+    void setNumThreads( const std::size_t& numThreads );
+
+    /*!
+     * @brief Gets the number of threads to verify with
+     */
+    const std::size_t& getNumThreads( void ) const;
+
+    /*!
+     * @brief Verifies all levels of a collection
+     * The collection must not be changed by other threads while this runs.
+     * @param collection The collection to verify
+     */
+    void verify( Collection& collection );
+
+    /*!
+     * @brief Gets the results of the last verification, in the order of the levels
+     */
+    const std::vector<Result>& getResults( void ) const;
+
+    /*!
+     * @brief Gets the number of levels which were solved in the last verification
+     */
+    std::size_t getNumSolved( void ) const;
+
+    /*!
+     * @brief Gets the time in seconds the last verification took
+     */
+    const double& getElapsedTime( void ) const;
+
+    /*!
+     * @brief Gets the number of levels verified per second in the last verification
+     */
+    double getLevelsPerSecond( void ) const;
+
+    /*!
+     * @brief Replays the undo data of a single level
+     * This doesn't change the level.
+     * @param level The level to verify
+     * @param result Receives the outcome, apart from the level name
+     */
+    static void verifyLevel( const Level& level, Result& result );
+
+private:
+
+    std::size_t             m_NumThreads;
+    std::vector<Result>     m_Results;
+    double                  m_ElapsedTime;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_SOLUTION_VERIFIER_HPP__
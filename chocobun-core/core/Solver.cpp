@@ -0,0 +1,754 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// Solver.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Solver.hpp>
+#include <core/Level.hpp>
+#include <core/Bitboard.hpp>
+#include <core/Exception.hpp>
+
+#include <algorithm> // std::sort, std::reverse, std::min, std::max
+#include <cstring>   // std::memcmp, std::memcpy
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// constants
+
+namespace {
+
+const Uint32 NO_SQUARE   = 0xFFFFFFFF;
+const Uint32 UNREACHABLE = 0xFFFFFFFF;
+const Uint32 NO_NODE     = 0xFFFFFFFF;
+
+// directions are ordered so the opposite of direction d is d^1
+const char MOVE_CHARS[] = "udlr";
+const char PUSH_CHARS[] = "UDLR";
+
+// nodes expanded per batch and worker, and the smallest batch worth
+// spreading across threads
+const std::size_t BATCH_SIZE = 4096;
+const std::size_t MIN_PARALLEL_BATCH = 64;
+
+// --------------------------------------------------------------
+inline bool testBit( const Uint64* words, const Uint32& bit )
+{
+    return ( (words[bit >> 6] >> (bit & 63)) & 1 ) != 0;
+}
+
+// --------------------------------------------------------------
+inline void setBit( Uint64* words, const Uint32& bit )
+{
+    words[bit >> 6] |= Uint64(1) << (bit & 63);
+}
+
+// --------------------------------------------------------------
+inline void clearBit( Uint64* words, const Uint32& bit )
+{
+    words[bit >> 6] &= ~(Uint64(1) << (bit & 63));
+}
+
+// --------------------------------------------------------------
+inline Uint64 packNode( const Uint32& cost, const Uint32& parent )
+{
+    return ( Uint64(cost) << 32 ) | parent;
+}
+
+// --------------------------------------------------------------
+inline Uint32 nodeCost( const Uint64& node )
+{
+    return static_cast<Uint32>( node >> 32 );
+}
+
+// --------------------------------------------------------------
+inline Uint32 nodeParent( const Uint64& node )
+{
+    return static_cast<Uint32>( node );
+}
+
+} // anonymous namespace
+
+// --------------------------------------------------------------
+bool Solver::Candidate::operator<( const Candidate& that ) const
+{
+    if( position != that.position ) return position < that.position;
+    return sequence < that.sequence;
+}
+
+// --------------------------------------------------------------
+Solver::Solver( void ) :
+    m_Metric( METRIC_PUSHES ),
+    m_MemoryLimit( 512 * 1024 * 1024 ),
+    m_TimeLimit( 60.0 ),
+    m_NumThreads( 0 ),
+    m_Reproducible( false ),
+    m_NumSquares( 0 ),
+    m_NumBoxes( 0 ),
+    m_BoxWords( 0 ),
+    m_StateWords( 0 ),
+    m_StartSquare( NO_SQUARE ),
+    m_NumNodes( 0 ),
+    m_Capacity( 0 ),
+    m_ExpandedStates( 0 )
+{
+}
+
+// --------------------------------------------------------------
+Solver::~Solver( void )
+{
+}
+
+// --------------------------------------------------------------
+void Solver::setMetric( const Metric& metric )
+{
+    m_Metric = metric;
+}
+
+// --------------------------------------------------------------
+const Solver::Metric& Solver::getMetric( void ) const
+{
+    return m_Metric;
+}
+
+// --------------------------------------------------------------
+void Solver::setMemoryLimit( const std::size_t& bytes )
+{
+    m_MemoryLimit = bytes;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Solver::getMemoryLimit( void ) const
+{
+    return m_MemoryLimit;
+}
+
+// --------------------------------------------------------------
+void Solver::setTimeLimit( const double& seconds )
+{
+    m_TimeLimit = seconds;
+}
+
+// --------------------------------------------------------------
+const double& Solver::getTimeLimit( void ) const
+{
+    return m_TimeLimit;
+}
+
+// --------------------------------------------------------------
+void Solver::setNumThreads( const std::size_t& numThreads )
+{
+    m_NumThreads = numThreads;
+}
+
+// --------------------------------------------------------------
+const std::size_t& Solver::getNumThreads( void ) const
+{
+    return m_NumThreads;
+}
+
+// --------------------------------------------------------------
+void Solver::setReproducible( const bool& reproducible )
+{
+    m_Reproducible = reproducible;
+}
+
+// --------------------------------------------------------------
+const bool& Solver::isReproducible( void ) const
+{
+    return m_Reproducible;
+}
+
+// --------------------------------------------------------------
+std::size_t Solver::getNumExpandedStates( void ) const
+{
+    return m_ExpandedStates;
+}
+
+// --------------------------------------------------------------
+std::size_t Solver::getNumStoredStates( void ) const
+{
+    return m_NumNodes.load();
+}
+
+// --------------------------------------------------------------
+Solver::Result Solver::solve( const Level& level, std::string& solution )
+{
+#ifdef _DEBUG
+    std::cout << "solving level " << level.getLevelName() << std::endl;
+#endif
+
+    // release everything from the last search
+    std::size_t numThreads = m_NumThreads;
+    if( !numThreads ) numThreads = std::thread::hardware_concurrency();
+    if( !numThreads ) numThreads = 1;
+    m_States.clear();
+    m_Nodes.clear();
+    m_Table.clear();
+    m_NumNodes.store( 0 );
+    m_Capacity = 0;
+    m_Buckets.clear();
+    m_Batch.clear();
+    m_ExpandedStates = 0;
+    m_Workers.assign( numThreads, Worker() );
+    for( std::size_t i = 0; i != numThreads; ++i )
+        m_Workers[i].id = static_cast<Uint32>( i );
+    std::vector<WorkStealingQueue>( numThreads ).swap( m_Queues );
+
+    if( !this->prepare( level ) )
+        return RESULT_UNSOLVABLE;
+
+    // the root node
+    if( !this->reserveNodes( 1 ) )
+        return RESULT_MEMORY_LIMIT;
+    std::vector<OpenEntry>& rootOutput = m_Workers[0].output;
+    this->addState( &m_RootState[0], 0, NO_NODE, this->estimateRemainingPushes( &m_RootState[0] ), rootOutput );
+    m_Buckets.resize( rootOutput[0].estimate + 1 );
+    m_Buckets.back().push_back( rootOutput[0] );
+    rootOutput.clear();
+
+    // the estimate of a child is never lower than the estimate of its parent,
+    // so buckets below the current one never receive nodes again
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::size_t bucket = 0;
+    for(;;)
+    {
+        while( bucket != m_Buckets.size() && m_Buckets[bucket].empty() ) ++bucket;
+        if( bucket == m_Buckets.size() )
+            return RESULT_UNSOLVABLE;
+
+        if( m_TimeLimit > 0.0 &&
+            std::chrono::duration<double>( std::chrono::steady_clock::now()-startTime ).count() > m_TimeLimit )
+            return RESULT_TIME_LIMIT;
+
+        // every child needs a free node, limit the batch to what still fits
+        std::size_t childrenPerNode = std::max<std::size_t>( m_NumBoxes, 1 ) * 4;
+        std::size_t maxBatch = std::min( ( m_Reproducible ? BATCH_SIZE : BATCH_SIZE * numThreads ),
+                                         ( this->getMaxNodes() - m_NumNodes.load() ) / childrenPerNode );
+        if( !maxBatch )
+            return RESULT_MEMORY_LIMIT;
+
+        // take the batch from the back of the bucket, so nodes added last are
+        // expanded first. Skip nodes for which a cheaper path was found after
+        // they were added.
+        std::vector<OpenEntry>& open = m_Buckets[bucket];
+        m_Batch.clear();
+        while( !open.empty() && m_Batch.size() != maxBatch )
+        {
+            OpenEntry entry = open.back();
+            open.pop_back();
+            if( nodeCost( m_Nodes[entry.node].load( std::memory_order_relaxed ) ) != entry.cost ) continue;
+            if( this->isGoalState( &m_States[entry.node * m_StateWords] ) )
+            {
+                this->buildSolution( entry.node, solution );
+                return RESULT_SOLVED;
+            }
+            m_Batch.push_back( entry );
+        }
+        if( m_Batch.empty() ) continue;
+
+        if( !this->reserveNodes( m_NumNodes.load() + m_Batch.size() * childrenPerNode ) )
+            return RESULT_MEMORY_LIMIT;
+        this->expandBatch();
+
+        // in reproducible mode, add the generated states in the order a
+        // single thread would have generated them
+        if( m_Reproducible )
+        {
+            m_Candidates.clear();
+            for( std::vector<Worker>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it )
+            {
+                m_Candidates.insert( m_Candidates.end(), it->candidates.begin(), it->candidates.end() );
+                it->candidates.clear();
+            }
+            std::sort( m_Candidates.begin(), m_Candidates.end() );
+            for( std::vector<Candidate>::iterator it = m_Candidates.begin(); it != m_Candidates.end(); ++it )
+                this->addState( &m_Workers[it->worker].candidateStates[it->state],
+                                it->cost, it->parent, it->estimate, m_Workers[0].output );
+            for( std::vector<Worker>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it )
+                it->candidateStates.clear();
+        }
+
+        // move new open entries into their buckets
+        for( std::vector<Worker>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it )
+        {
+            for( std::vector<OpenEntry>::iterator entry = it->output.begin(); entry != it->output.end(); ++entry )
+            {
+                if( entry->estimate >= m_Buckets.size() )
+                    m_Buckets.resize( entry->estimate + 1 );
+                m_Buckets[entry->estimate].push_back( *entry );
+            }
+            it->output.clear();
+        }
+    }
+}
+
+// --------------------------------------------------------------
+bool Solver::prepare( const Level& level )
+{
+    const Bitboard& walls = level.getWallBoard();
+    const Bitboard& goals = level.getGoalBoard();
+    const Bitboard& boxes = level.getBoxBoard();
+    if( !level.isValid() || walls.size() == 0 )
+        throw Exception( "[Solver::solve] Error: level must be validated and reset before solving" );
+
+    // all squares the player could ever walk on, ignoring boxes
+    std::size_t playerIndex = walls.index( level.getPlayerX(), level.getPlayerY() );
+    Bitboard region( walls.sizeX(), walls.sizeY() );
+    Bitboard passable( walls );
+    passable.invert();
+    region.set( playerIndex );
+    region.floodFill( passable );
+
+    // number the squares of the region
+    std::vector<Uint32> indexToSquare( walls.size(), NO_SQUARE );
+    std::vector<std::size_t>& squareToIndex = m_SquareToIndex;
+    squareToIndex.clear();
+    for( std::size_t i = region.findFirst(); i != Bitboard::npos; i = region.findNext(i) )
+    {
+        indexToSquare[i] = static_cast<Uint32>( squareToIndex.size() );
+        squareToIndex.push_back( i );
+    }
+    m_NumSquares = squareToIndex.size();
+    m_BoxWords = (m_NumSquares + 63) >> 6;
+    m_StateWords = m_BoxWords + 1;
+    m_StartSquare = indexToSquare[playerIndex];
+
+    // neighbours of every square, in the order up, down, left, right
+    std::size_t delta[4] = { static_cast<std::size_t>(0)-walls.stride(), walls.stride(),
+                             static_cast<std::size_t>(0)-1, 1 };
+    m_Neighbours.resize( m_NumSquares * 4 );
+    for( std::size_t square = 0; square != m_NumSquares; ++square )
+        for( std::size_t direction = 0; direction != 4; ++direction )
+            m_Neighbours[square*4 + direction] = indexToSquare[squareToIndex[square] + delta[direction]];
+
+    // goals, boxes and squares boxes must never be pushed onto
+    const Bitboard& dead = level.getDeadSquareBoard();
+    m_Goals.assign( m_BoxWords, 0 );
+    m_DeadSquares.assign( m_BoxWords, 0 );
+    m_RootState.assign( m_StateWords, 0 );
+    std::size_t numGoals = 0;
+    m_NumBoxes = 0;
+    for( std::size_t square = 0; square != m_NumSquares; ++square )
+    {
+        if( goals.test( squareToIndex[square] ) ){ setBit( &m_Goals[0], square ); ++numGoals; }
+        if( boxes.test( squareToIndex[square] ) ){ setBit( &m_RootState[0], square ); ++m_NumBoxes; }
+        if( dead.test( squareToIndex[square] ) ) setBit( &m_DeadSquares[0], square );
+    }
+
+    // a box the player can never get to must already be on a goal
+    for( std::size_t i = boxes.findFirst(); i != Bitboard::npos; i = boxes.findNext(i) )
+        if( !region.test(i) && !goals.test(i) )
+            return false;
+    if( m_NumBoxes > numGoals )
+        return false;
+
+    for( Uint32 square = 0; square != m_NumSquares; ++square )
+        if( testBit( &m_RootState[0], square ) && testBit( &m_DeadSquares[0], square ) )
+            return false;
+
+    // lower bound of pushes required to get a box from any square to a goal,
+    // found by pulling boxes backwards away from all goals at once. Squares
+    // which aren't dead are always reached.
+    std::vector<Uint32>& queue = m_Workers[0].queue;
+    m_GoalDistance.assign( m_NumSquares, UNREACHABLE );
+    queue.clear();
+    for( Uint32 square = 0; square != m_NumSquares; ++square )
+        if( testBit( &m_Goals[0], square ) )
+        {
+            m_GoalDistance[square] = 0;
+            queue.push_back( square );
+        }
+    for( std::size_t head = 0; head != queue.size(); ++head )
+    {
+        Uint32 square = queue[head];
+        for( Uint32 direction = 0; direction != 4; ++direction )
+        {
+            Uint32 from = m_Neighbours[square*4 + (direction^1)];
+            if( from == NO_SQUARE ) continue;
+            Uint32 pusher = m_Neighbours[from*4 + (direction^1)];
+            if( pusher == NO_SQUARE || m_GoalDistance[from] != UNREACHABLE ) continue;
+            m_GoalDistance[from] = m_GoalDistance[square] + 1;
+            queue.push_back( from );
+        }
+    }
+
+    m_DeadlockDetector.prepare( level );
+    for( std::vector<Worker>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it )
+        it->boxes.resize( walls.sizeX(), walls.sizeY() );
+
+    m_RootState[m_BoxWords] = ( m_Metric == METRIC_PUSHES ?
+                                this->normalisePlayer( m_StartSquare, &m_RootState[0], m_Workers[0] ) : m_StartSquare );
+    return true;
+}
+
+// --------------------------------------------------------------
+void Solver::expandBatch( void )
+{
+
+    // small batches aren't worth the cost of starting threads
+    std::size_t numWorkers = ( m_Batch.size() < MIN_PARALLEL_BATCH ? 1 : m_Workers.size() );
+
+    // deal out consecutive parts of the batch, idle workers steal the rest
+    m_Positions.resize( m_Batch.size() );
+    for( std::size_t i = 0; i != m_Positions.size(); ++i )
+        m_Positions[i] = static_cast<Uint32>( i );
+    for( std::size_t i = 0; i != numWorkers; ++i )
+    {
+        std::size_t begin = m_Batch.size() * i / numWorkers;
+        std::size_t end = m_Batch.size() * (i+1) / numWorkers;
+        m_Queues[i].assign( &m_Positions[0] + begin, end - begin );
+    }
+
+    std::vector<std::thread> threads;
+    for( std::size_t i = 1; i < numWorkers; ++i )
+        threads.push_back( std::thread( &Solver::runWorker, this, i, numWorkers ) );
+    this->runWorker( 0, numWorkers );
+    for( std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it )
+        it->join();
+
+    m_ExpandedStates += m_Batch.size();
+}
+
+// --------------------------------------------------------------
+void Solver::runWorker( const std::size_t& id, const std::size_t& numWorkers )
+{
+    Worker& worker = m_Workers[id];
+    Uint32 position;
+    while( m_Queues[id].pop( position ) )
+        this->expand( position, worker );
+
+    // nothing is added to the queues during a batch, so once every queue was
+    // seen empty the batch is done
+    for( std::size_t i = 1; i != numWorkers; ++i )
+    {
+        WorkStealingQueue& victim = m_Queues[(id+i) % numWorkers];
+        while( victim.steal( position ) )
+            this->expand( position, worker );
+    }
+}
+
+// --------------------------------------------------------------
+void Solver::expand( const Uint32& position, Worker& worker )
+{
+    const OpenEntry& entry = m_Batch[position];
+    const Uint64* state = &m_States[entry.node * m_StateWords];
+    worker.child.assign( state, state + m_StateWords );
+    Uint64* child = &worker.child[0];
+    Uint32 player = static_cast<Uint32>( child[m_BoxWords] );
+    Uint32 estimate = entry.estimate - entry.cost;
+    Uint32 sequence = 0;
+
+    // normalising the player of the children overwrites the distances,
+    // so keep them in a separate buffer
+    this->calculatePlayerDistances( player, child, worker );
+    worker.reachable.swap( worker.distance );
+    const std::vector<Uint32>& distance = worker.reachable;
+
+    // the deadlock detector works on bitboards of the level
+    Bitboard& boxes = worker.boxes;
+    boxes.clear();
+    for( Uint32 square = 0; square != m_NumSquares; ++square )
+        if( testBit( child, square ) ) boxes.set( m_SquareToIndex[square] );
+
+    // try pushing every box the player can reach in every direction
+    for( Uint32 box = 0; box != m_NumSquares; ++box )
+    {
+        if( !testBit( child, box ) ) continue;
+        for( Uint32 direction = 0; direction != 4; ++direction )
+        {
+            Uint32 target = m_Neighbours[box*4 + direction];
+            Uint32 pusher = m_Neighbours[box*4 + (direction^1)];
+            if( target == NO_SQUARE || pusher == NO_SQUARE ) continue;
+            if( distance[pusher] == UNREACHABLE ) continue;
+            if( testBit( child, target ) ) continue;
+            if( testBit( &m_DeadSquares[0], target ) ) continue;
+
+            // skip pushes leading to deadlocks
+            std::size_t boxIndex = m_SquareToIndex[box], targetIndex = m_SquareToIndex[target];
+            boxes.reset( boxIndex );
+            boxes.set( targetIndex );
+            bool deadlock = m_DeadlockDetector.isFrozenDeadlock( boxes, targetIndex ) ||
+                            m_DeadlockDetector.isBipartiteDeadlock( boxes, boxIndex, targetIndex );
+            boxes.reset( targetIndex );
+            boxes.set( boxIndex );
+            if( deadlock ) continue;
+
+            // apply push
+            clearBit( child, box );
+            setBit( child, target );
+            if( m_Metric == METRIC_PUSHES )
+                child[m_BoxWords] = this->normalisePlayer( box, child, worker );
+            else
+                child[m_BoxWords] = box;
+
+            Uint32 cost = entry.cost + ( m_Metric == METRIC_PUSHES ? 1 : distance[pusher]+1 );
+            Uint32 childEstimate = cost + estimate - m_GoalDistance[box] + m_GoalDistance[target];
+            if( m_Reproducible )
+            {
+                Candidate candidate = { position, sequence++, worker.id, entry.node,
+                                        cost, childEstimate, worker.candidateStates.size() };
+                worker.candidates.push_back( candidate );
+                worker.candidateStates.insert( worker.candidateStates.end(), child, child + m_StateWords );
+            }
+            else
+                this->addState( child, cost, entry.node, childEstimate, worker.output );
+
+            // revert push
+            clearBit( child, target );
+            setBit( child, box );
+            child[m_BoxWords] = player;
+        }
+    }
+}
+
+// --------------------------------------------------------------
+void Solver::calculatePlayerDistances( const Uint32& start, const Uint64* boxes, Worker& worker ) const
+{
+    std::vector<Uint32>& distance = worker.distance;
+    std::vector<Uint32>& queue = worker.queue;
+    distance.assign( m_NumSquares, UNREACHABLE );
+    queue.clear();
+    distance[start] = 0;
+    queue.push_back( start );
+    for( std::size_t head = 0; head != queue.size(); ++head )
+    {
+        Uint32 square = queue[head];
+        for( Uint32 direction = 0; direction != 4; ++direction )
+        {
+            Uint32 next = m_Neighbours[square*4 + direction];
+            if( next == NO_SQUARE || distance[next] != UNREACHABLE || testBit( boxes, next ) ) continue;
+            distance[next] = distance[square] + 1;
+            queue.push_back( next );
+        }
+    }
+}
+
+// --------------------------------------------------------------
+Uint32 Solver::normalisePlayer( const Uint32& start, const Uint64* boxes, Worker& worker ) const
+{
+    this->calculatePlayerDistances( start, boxes, worker );
+    Uint32 lowest = start;
+    for( std::size_t i = 0; i != worker.queue.size(); ++i )
+        if( worker.queue[i] < lowest ) lowest = worker.queue[i];
+    return lowest;
+}
+
+// --------------------------------------------------------------
+Uint32 Solver::estimateRemainingPushes( const Uint64* boxes ) const
+{
+    Uint32 total = 0;
+    for( Uint32 square = 0; square != m_NumSquares; ++square )
+        if( testBit( boxes, square ) )
+            total += m_GoalDistance[square];
+    return total;
+}
+
+// --------------------------------------------------------------
+bool Solver::isGoalState( const Uint64* boxes ) const
+{
+    for( std::size_t i = 0; i != m_BoxWords; ++i )
+        if( boxes[i] & ~m_Goals[i] ) return false;
+    return true;
+}
+
+// --------------------------------------------------------------
+void Solver::addState( const Uint64* state, const Uint32& cost, const Uint32& parent,
+                       const Uint32& estimate, std::vector<OpenEntry>& output )
+{
+    std::size_t mask = m_Table.size() - 1;
+    std::size_t slot = static_cast<std::size_t>( this->hashState( state ) ) & mask;
+    Uint32 reserved = NO_NODE;
+    for(;;)
+    {
+        Uint32 stored = m_Table[slot].load( std::memory_order_acquire );
+        if( !stored )
+        {
+
+            // write the state to a fresh node, then try to publish it
+            if( reserved == NO_NODE )
+            {
+                reserved = m_NumNodes.fetch_add( 1, std::memory_order_relaxed );
+                std::memcpy( &m_States[reserved * m_StateWords], state, m_StateWords * sizeof(Uint64) );
+                m_Nodes[reserved].store( packNode( cost, parent ), std::memory_order_relaxed );
+            }
+            if( m_Table[slot].compare_exchange_strong( stored, reserved+1, std::memory_order_acq_rel ) )
+            {
+                OpenEntry entry = { estimate, cost, reserved };
+                output.push_back( entry );
+                return;
+            }
+
+            // another thread took the slot first, stored now holds its node
+        }
+
+        const Uint64* other = &m_States[(stored-1) * m_StateWords];
+        if( std::memcmp( other, state, m_StateWords * sizeof(Uint64) ) == 0 )
+        {
+
+            // another thread added the same state first, the reserved node is
+            // never referenced
+            if( reserved != NO_NODE )
+                m_Nodes[reserved].store( packNode( UNREACHABLE, NO_NODE ), std::memory_order_relaxed );
+
+            // known state, only update it if this path is cheaper
+            std::atomic<Uint64>& node = m_Nodes[stored-1];
+            Uint64 current = node.load( std::memory_order_relaxed );
+            while( nodeCost( current ) > cost )
+            {
+                if( node.compare_exchange_weak( current, packNode( cost, parent ), std::memory_order_relaxed ) )
+                {
+                    OpenEntry entry = { estimate, cost, stored-1 };
+                    output.push_back( entry );
+                    break;
+                }
+            }
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+// --------------------------------------------------------------
+bool Solver::reserveNodes( const std::size_t& numNodes )
+{
+    if( numNodes <= m_Capacity ) return true;
+    std::size_t maxNodes = this->getMaxNodes();
+    if( numNodes > maxNodes ) return false;
+
+    // grow the pool
+    std::size_t capacity = std::min( std::max( numNodes, m_Capacity * 2 ), maxNodes );
+    std::size_t used = m_NumNodes.load();
+    m_States.resize( capacity * m_StateWords );
+    std::vector< std::atomic<Uint64> > nodes( capacity );
+    for( std::size_t i = 0; i != used; ++i )
+        nodes[i].store( m_Nodes[i].load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    m_Nodes.swap( nodes );
+    m_Capacity = capacity;
+
+    // keep the load factor of the table at or below 50%
+    std::size_t tableSize = 1024;
+    while( tableSize < capacity * 2 ) tableSize *= 2;
+    if( tableSize == m_Table.size() ) return true;
+    std::vector< std::atomic<Uint32> > table( tableSize );
+    for( std::size_t i = 0; i != m_Table.size(); ++i )
+    {
+        Uint32 stored = m_Table[i].load( std::memory_order_relaxed );
+        if( !stored ) continue;
+        std::size_t slot = static_cast<std::size_t>( this->hashState( &m_States[(stored-1) * m_StateWords] ) ) & (tableSize-1);
+        while( table[slot].load( std::memory_order_relaxed ) )
+            slot = (slot + 1) & (tableSize-1);
+        table[slot].store( stored, std::memory_order_relaxed );
+    }
+    m_Table.swap( table );
+    return true;
+}
+
+// --------------------------------------------------------------
+std::size_t Solver::getMaxNodes( void ) const
+{
+
+    // a node needs its state, the packed node, up to four table slots and
+    // an open list entry
+    std::size_t bytesPerNode = m_StateWords * sizeof(Uint64) + sizeof(Uint64) +
+                               4 * sizeof(Uint32) + sizeof(OpenEntry);
+    return std::min<std::size_t>( m_MemoryLimit / bytesPerNode, NO_NODE - 1 );
+}
+
+// --------------------------------------------------------------
+Uint64 Solver::hashState( const Uint64* state ) const
+{
+    Uint64 hash = 0x9E3779B97F4A7C15ULL;
+    for( std::size_t i = 0; i != m_StateWords; ++i )
+    {
+        hash ^= state[i];
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+// --------------------------------------------------------------
+void Solver::buildSolution( Uint32 node, std::string& solution )
+{
+
+    // collect states from the goal back to the root
+    std::vector<Uint32> path;
+    for( ; node != NO_NODE; node = nodeParent( m_Nodes[node].load() ) )
+        path.push_back( node );
+    std::reverse( path.begin(), path.end() );
+
+    // replay pushes, walking the player to each pushing position. The pushed
+    // box is the only difference between two consecutive states.
+    solution.clear();
+    std::vector<Uint64> boxes( m_RootState.begin(), m_RootState.begin() + m_BoxWords );
+    Uint32 player = m_StartSquare;
+    for( std::size_t i = 1; i < path.size(); ++i )
+    {
+        const Uint64* before = &m_States[path[i-1] * m_StateWords];
+        const Uint64* after = &m_States[path[i] * m_StateWords];
+        Uint32 box = NO_SQUARE, target = NO_SQUARE;
+        for( Uint32 square = 0; square != m_NumSquares; ++square )
+        {
+            bool wasBox = testBit( before, square ), isBox = testBit( after, square );
+            if( wasBox && !isBox ) box = square;
+            if( !wasBox && isBox ) target = square;
+        }
+        Uint32 direction = 0;
+        while( m_Neighbours[box*4 + direction] != target ) ++direction;
+
+        this->appendWalk( player, m_Neighbours[box*4 + (direction^1)], &boxes[0], solution );
+        solution.push_back( PUSH_CHARS[direction] );
+        clearBit( &boxes[0], box );
+        setBit( &boxes[0], target );
+        player = box;
+    }
+}
+
+// --------------------------------------------------------------
+void Solver::appendWalk( const Uint32& from, const Uint32& to, const Uint64* boxes, std::string& solution )
+{
+
+    // search backwards so the path can be read in forward order
+    Worker& worker = m_Workers[0];
+    this->calculatePlayerDistances( to, boxes, worker );
+    const std::vector<Uint32>& distance = worker.distance;
+    Uint32 square = from;
+    while( square != to )
+    {
+        for( Uint32 direction = 0; direction != 4; ++direction )
+        {
+            Uint32 next = m_Neighbours[square*4 + direction];
+            if( next != NO_SQUARE && distance[next] != UNREACHABLE && distance[next]+1 == distance[square] )
+            {
+                solution.push_back( MOVE_CHARS[direction] );
+                square = next;
+                break;
+            }
+        }
+    }
+}
+
+} // namespace Chocobun
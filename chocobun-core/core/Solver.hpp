@@ -0,0 +1,353 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// Solver.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_SOLVER_HPP__
+#define __CHOCOBUN_CORE_SOLVER_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <core/WorkStealingQueue.hpp>
+#include <core/DeadlockDetector.hpp>
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// forward declarations
+
+class Level;
+
+/*!
+ * @brief Finds optimal solutions for levels
+ *
+ * The solver performs an A* search over box configurations. Every edge of
+ * the search graph is a single push, and the player is walked to the
+ * pushing position along a shortest path.
+ *
+ * Each state is encoded as a bit per floor square holding a box plus the
+ * position of the player. All states live in one flat pool, and a
+ * transposition table makes sure no state is expanded twice. The search
+ * stops when either the memory budget or the time limit is exceeded.
+ *
+ * Pushes leading to frozen boxes or to boxes which can't all be assigned
+ * a goal are never searched (see DeadlockDetector).
+ *
+ * Open states are kept in buckets by their estimated total cost. The
+ * lowest bucket is expanded in batches, and every batch is spread across
+ * the worker threads through work stealing queues. Workers add the states
+ * they generate to a shared lock-free transposition table. In reproducible
+ * mode the generated states are instead merged in a fixed order after each
+ * batch, so the result doesn't depend on the number of threads or on
+ * their timing.
+ *
+ * The returned solution is a LURD string which can be passed directly to
+ * Level::importUndoData.
+ */
+class Solver
+{
+public:
+
+    /*!
+     * @brief What the solution should be optimal in
+     */
+    enum Metric
+    {
+        METRIC_PUSHES,  //!< Minimal number of pushes
+        METRIC_MOVES    //!< Minimal number of moves (including pushes)
+    };
+
+    /*!
+     * @brief Outcome of a call to @a solve
+     */
+    enum Result
+    {
+        RESULT_SOLVED,          //!< A solution was found
+        RESULT_UNSOLVABLE,      //!< The whole search space was exhausted
+        RESULT_TIME_LIMIT,      //!< The time limit was reached
+        RESULT_MEMORY_LIMIT     //!< The memory budget was exhausted
+    };
+
+    /*!
+     * @brief Constructor
+     */
+    Solver( void );
+
+    /*!
+     * @brief Destructor
+     */
+    ~Solver( void );
+
+    /*!
+     * @brief Sets what the solution should be optimal in
+     * @note Default is <b>METRIC_PUSHES</b>
+     */
+    void setMetric( const Metric& metric );
+
+    /*!
+     * @brief Gets what the solution should be optimal in
+     */
+    const Metric& getMetric( void ) const;
+
+    /*!
+     * @brief Sets the maximum amount of memory the search may use
+     * @note Default is 512 MiB
+     * @param bytes The memory budget in bytes
+     */
+    void setMemoryLimit( const std::size_t& bytes );
+
+    /*!
+     * @brief Gets the maximum amount of memory the search may use
+     */
+    const std::size_t& getMemoryLimit( void ) const;
+
+    /*!
+     * @brief Sets the maximum amount of time the search may take
+     * @note Default is 60 seconds
+     * @param seconds The time limit in seconds. Set to 0 to disable.
+     */
+    void setTimeLimit( const double& seconds );
+
+    /*!
+     * @brief Gets the maximum amount of time the search may take
+     */
+    const double& getTimeLimit( void ) const;
+
+    /*!
+     * @brief Sets the number of worker threads to search with
+     * @note Default is 0
+     * @param numThreads The number of threads. Set to 0 to use one thread
+     * per hardware core.
+     */
+    void setNumThreads( const std::size_t& numThreads );
+
+    /*!
+     * @brief Gets the number of worker threads to search with
+     */
+    const std::size_t& getNumThreads( void ) const;
+
+    /*!
+     * @brief Sets whether searches should be reproducible
+     * When enabled, the same level always yields the same solution and the
+     * same statistics, regardless of the number of threads. This costs some
+     * speed, because generated states are merged by a single thread.
+     * @note Default is false
+     */
+    void setReproducible( const bool& reproducible );
+
+    /*!
+     * @brief Gets whether searches are reproducible
+     */
+    const bool& isReproducible( void ) const;
+
+    /*!
+     * @brief Searches for a solution
+     *
+     * The search starts from the <b>current</b> state of the level. Call
+     * Level::reset first to solve the level from its initial state.
+     *
+     * @exception Chocobun::Exception if the level hasn't been validated and reset
+     * @param level The level to solve. It is not modified.
+     * @param solution If a solution is found, it is written to this string as
+     * a sequence of moves (u, d, l, r) and pushes (U, D, L, R).
+     * @return Returns RESULT_SOLVED if a solution was found.
+     */
+    Result solve( const Level& level, std::string& solution );
+
+    /*!
+     * @brief Gets the number of states expanded during the last search
+     */
+    std::size_t getNumExpandedStates( void ) const;
+
+    /*!
+     * @brief Gets the number of distinct states stored during the last search
+     */
+    std::size_t getNumStoredStates( void ) const;
+
+private:
+
+    /*!
+     * @brief An entry in the open list
+     */
+    struct OpenEntry
+    {
+        Uint32 estimate;    // cost plus lower bound of the remaining cost
+        Uint32 cost;        // pushes or moves from the root node
+        Uint32 node;
+    };
+
+    /*!
+     * @brief A state generated in reproducible mode, waiting to be merged
+     */
+    struct Candidate
+    {
+        Uint32 position;    // position of the parent in the batch
+        Uint32 sequence;    // order in which the parent generated it
+        Uint32 worker;      // worker holding the state
+        Uint32 parent;
+        Uint32 cost;
+        Uint32 estimate;
+        std::size_t state;  // offset of the state in the worker's buffer
+        bool operator<( const Candidate& that ) const;
+    };
+
+    /*!
+     * @brief Buffers owned by a single worker thread
+     */
+    struct Worker
+    {
+        Uint32 id;
+        std::vector<Uint32> distance;
+        std::vector<Uint32> reachable;
+        std::vector<Uint32> queue;
+        std::vector<Uint64> child;
+        Bitboard boxes;
+        std::vector<OpenEntry> output;
+        std::vector<Candidate> candidates;
+        std::vector<Uint64> candidateStates;
+    };
+
+    /*!
+     * @brief Builds the square graph and goal distances from a level
+     * @return Returns false if the level can trivially be proven unsolvable
+     */
+    bool prepare( const Level& level );
+
+    /*!
+     * @brief Expands every node of the current batch on all workers
+     */
+    void expandBatch( void );
+
+    /*!
+     * @brief Main loop of a worker thread
+     * Expands nodes of its own queue first, then steals from the others.
+     */
+    void runWorker( const std::size_t& id, const std::size_t& numWorkers );
+
+    /*!
+     * @brief Generates all children of a node in the current batch
+     */
+    void expand( const Uint32& position, Worker& worker );
+
+    /*!
+     * @brief Calculates the walking distance from a square to all other squares
+     * Boxes block the player. Unreachable squares are set to UNREACHABLE.
+     */
+    void calculatePlayerDistances( const Uint32& start, const Uint64* boxes, Worker& worker ) const;
+
+    /*!
+     * @brief Finds the lowest square the player can walk to
+     * This is used to normalise the player position when optimising pushes.
+     */
+    Uint32 normalisePlayer( const Uint32& start, const Uint64* boxes, Worker& worker ) const;
+
+    /*!
+     * @brief Sum of the push distances of all boxes to their nearest goal
+     */
+    Uint32 estimateRemainingPushes( const Uint64* boxes ) const;
+
+    /*!
+     * @brief Checks if every box of a state is on a goal
+     */
+    bool isGoalState( const Uint64* boxes ) const;
+
+    /*!
+     * @brief Adds a state to the pool if it isn't known yet or was reached more cheaply
+     * This is safe to call from multiple threads at once. Enough capacity must
+     * have been reserved beforehand.
+     * @param output Receives an open list entry if the state has to be expanded
+     */
+    void addState( const Uint64* state, const Uint32& cost, const Uint32& parent,
+                   const Uint32& estimate, std::vector<OpenEntry>& output );
+
+    /*!
+     * @brief Makes sure the pool and the transposition table can hold a number of nodes
+     * @note This is not thread safe
+     * @return Returns false if the memory budget would be exceeded
+     */
+    bool reserveNodes( const std::size_t& numNodes );
+
+    /*!
+     * @brief Gets the maximum number of nodes fitting in the memory budget
+     */
+    std::size_t getMaxNodes( void ) const;
+
+    /*!
+     * @brief Calculates the hash of a state
+     */
+    Uint64 hashState( const Uint64* state ) const;
+
+    /*!
+     * @brief Converts the chain of nodes leading to a goal state into a LURD string
+     */
+    void buildSolution( Uint32 node, std::string& solution );
+
+    /*!
+     * @brief Appends the shortest walk between two squares to a LURD string
+     */
+    void appendWalk( const Uint32& from, const Uint32& to, const Uint64* boxes, std::string& solution );
+
+    Metric                  m_Metric;
+    std::size_t             m_MemoryLimit;
+    double                  m_TimeLimit;
+    std::size_t             m_NumThreads;
+    bool                    m_Reproducible;
+
+    // square graph of the level being solved
+    std::size_t             m_NumSquares;
+    std::size_t             m_NumBoxes;
+    std::size_t             m_BoxWords;
+    std::size_t             m_StateWords;
+    std::vector<Uint32>     m_Neighbours;
+    std::vector<Uint32>     m_GoalDistance;
+    std::vector<Uint64>     m_Goals;
+    std::vector<Uint64>     m_DeadSquares;
+    std::vector<std::size_t> m_SquareToIndex;
+    DeadlockDetector        m_DeadlockDetector;
+    std::vector<Uint64>     m_RootState;
+    Uint32                  m_StartSquare;
+
+    // search, nodes are packed as cost in the upper and parent in the lower half
+    std::vector<Uint64>                 m_States;
+    std::vector< std::atomic<Uint64> >  m_Nodes;
+    std::vector< std::atomic<Uint32> >  m_Table;
+    std::atomic<Uint32>                 m_NumNodes;
+    std::size_t                         m_Capacity;
+    std::vector< std::vector<OpenEntry> > m_Buckets;
+    std::vector<OpenEntry>              m_Batch;
+    std::size_t                         m_ExpandedStates;
+
+    // workers
+    std::vector<Worker>                 m_Workers;
+    std::vector<WorkStealingQueue>      m_Queues;
+    std::vector<Uint32>                 m_Positions;
+    std::vector<Candidate>              m_Candidates;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_SOLVER_HPP__
@@ -0,0 +1,127 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// StringView.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/StringView.hpp>
+
+#include <cstring>
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+StringView::StringView( void ) :
+    m_Data( "" ),
+    m_Size( 0 )
+{
+}
+
+// --------------------------------------------------------------
+StringView::StringView( const char* data, const std::size_t& size ) :
+    m_Data( data ),
+    m_Size( size )
+{
+}
+
+// --------------------------------------------------------------
+StringView::StringView( const std::string& str ) :
+    m_Data( str.data() ),
+    m_Size( str.size() )
+{
+}
+
+// --------------------------------------------------------------
+const char* StringView::data( void ) const
+{
+    return m_Data;
+}
+
+// --------------------------------------------------------------
+const std::size_t& StringView::size( void ) const
+{
+    return m_Size;
+}
+
+// --------------------------------------------------------------
+bool StringView::empty( void ) const
+{
+    return ( m_Size == 0 );
+}
+
+// --------------------------------------------------------------
+const char& StringView::operator[]( const std::size_t& index ) const
+{
+    return m_Data[index];
+}
+
+// --------------------------------------------------------------
+std::size_t StringView::find( const char& chr, const std::size_t& pos ) const
+{
+    if( pos >= m_Size ) return std::string::npos;
+    const void* found = std::memchr( m_Data + pos, chr, m_Size - pos );
+    if( !found ) return std::string::npos;
+    return static_cast<const char*>( found ) - m_Data;
+}
+
+// --------------------------------------------------------------
+std::size_t StringView::find( const char* str, const std::size_t& pos ) const
+{
+    std::size_t length = std::strlen( str );
+    if( !length ) return ( pos <= m_Size ? pos : std::string::npos );
+    for( std::size_t i = this->find( str[0], pos ); i != std::string::npos; i = this->find( str[0], i+1 ) )
+    {
+        if( m_Size - i < length ) break;
+        if( std::memcmp( m_Data + i, str, length ) == 0 ) return i;
+    }
+    return std::string::npos;
+}
+
+// --------------------------------------------------------------
+StringView StringView::substr( const std::size_t& pos, const std::size_t& count ) const
+{
+    if( pos >= m_Size ) return StringView( m_Data + m_Size, 0 );
+    std::size_t available = m_Size - pos;
+    return StringView( m_Data + pos, count < available ? count : available );
+}
+
+// --------------------------------------------------------------
+StringView StringView::trim( void ) const
+{
+    std::size_t begin = 0, end = m_Size;
+    while( begin != end && m_Data[begin] == ' ' ) ++begin;
+    while( end != begin && m_Data[end-1] == ' ' ) --end;
+    return StringView( m_Data + begin, end - begin );
+}
+
+// --------------------------------------------------------------
+bool StringView::equals( const char* str ) const
+{
+    return ( std::strlen( str ) == m_Size && std::memcmp( m_Data, str, m_Size ) == 0 );
+}
+
+// --------------------------------------------------------------
+std::string StringView::str( void ) const
+{
+    return std::string( m_Data, m_Size );
+}
+
+} // namespace Chocobun
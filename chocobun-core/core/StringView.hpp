@@ -0,0 +1,124 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// StringView.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_STRING_VIEW_HPP__
+#define __CHOCOBUN_CORE_STRING_VIEW_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <string>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Refers to a range of characters owned by someone else
+ *
+ * Used to look at text without copying it, e.g. the lines of a memory
+ * mapped file. The characters must outlive the view. Use @a str to get a
+ * copy that can be kept.
+ */
+class StringView
+{
+public:
+
+    /*!
+     * @brief Constructs an empty view
+     */
+    StringView( void );
+
+    /*!
+     * @brief Constructs a view of a range of characters
+     */
+    StringView( const char* data, const std::size_t& size );
+
+    /*!
+     * @brief Constructs a view of a whole string
+     */
+    StringView( const std::string& str );
+
+    /*!
+     * @brief Gets a pointer to the first character
+     */
+    const char* data( void ) const;
+
+    /*!
+     * @brief Gets the number of characters
+     */
+    const std::size_t& size( void ) const;
+
+    /*!
+     * @brief Checks if the view has no characters
+     */
+    bool empty( void ) const;
+
+    /*!
+     * @brief Gets a character
+     */
+    const char& operator[]( const std::size_t& index ) const;
+
+    /*!
+     * @brief Finds the first occurrence of a character
+     * @return Returns the index of the character, or std::string::npos if
+     * it wasn't found
+     */
+    std::size_t find( const char& chr, const std::size_t& pos = 0 ) const;
+
+    /*!
+     * @brief Finds the first occurrence of a string
+     * @return Returns the index of the string, or std::string::npos if it
+     * wasn't found
+     */
+    std::size_t find( const char* str, const std::size_t& pos = 0 ) const;
+
+    /*!
+     * @brief Gets a part of the view
+     * The range is clamped to the view.
+     */
+    StringView substr( const std::size_t& pos, const std::size_t& count = std::string::npos ) const;
+
+    /*!
+     * @brief Gets the view without leading and trailing spaces
+     */
+    StringView trim( void ) const;
+
+    /*!
+     * @brief Checks if the characters match a null terminated string
+     */
+    bool equals( const char* str ) const;
+
+    /*!
+     * @brief Copies the characters into a string
+     */
+    std::string str( void ) const;
+
+private:
+
+    const char*     m_Data;
+    std::size_t     m_Size;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_STRING_VIEW_HPP__
@@ -0,0 +1,344 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// UndoHistory.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/UndoHistory.hpp>
+#include <core/Exception.hpp>
+
+#include <utility> // std::swap
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+// constants
+
+namespace {
+
+const std::size_t MOVES_PER_WORD = 21;
+const std::size_t NO_BRANCH = static_cast<std::size_t>(-1);
+const Uint8 INVALID_MOVE = 0xFF;
+
+// same order as the 3 bit codes: direction in the low bits, push flag on top
+const char MOVE_CHARS[] = "udlrUDLR";
+
+} // anonymous namespace
+
+// --------------------------------------------------------------
+UndoHistory::UndoHistory( void ) :
+    m_Size( 0 ),
+    m_Position( 0 ),
+    m_Branching( false )
+{
+}
+
+// --------------------------------------------------------------
+UndoHistory::~UndoHistory( void )
+{
+}
+
+// --------------------------------------------------------------
+void UndoHistory::swap( UndoHistory& that ) noexcept
+{
+    m_Words.swap( that.m_Words );
+    std::swap( m_Size, that.m_Size );
+    std::swap( m_Position, that.m_Position );
+    std::swap( m_Branching, that.m_Branching );
+    m_Branches.swap( that.m_Branches );
+}
+
+// --------------------------------------------------------------
+void UndoHistory::clear( void )
+{
+    m_Words.clear();
+    m_Size = 0;
+    m_Position = 0;
+    m_Branches.clear();
+}
+
+// --------------------------------------------------------------
+void UndoHistory::assign( const std::string& moves, const std::size_t& position )
+{
+    if( position > moves.size() )
+        throw Exception( "[UndoHistory::assign] Error: position is past the last move" );
+
+    std::vector<Uint64> words( (moves.size() + MOVES_PER_WORD - 1) / MOVES_PER_WORD, 0 );
+    for( std::size_t i = 0; i != moves.size(); ++i )
+    {
+        Uint8 code = encode( moves[i] );
+        if( code == INVALID_MOVE )
+            throw Exception( "[UndoHistory::assign] Error: invalid move" );
+        write( words, i, code );
+    }
+
+    m_Words.swap( words );
+    m_Size = moves.size();
+    m_Position = position;
+    m_Branches.clear();
+}
+
+// --------------------------------------------------------------
+void UndoHistory::push( const char& move )
+{
+    Uint8 code = encode( move );
+    if( code == INVALID_MOVE )
+        throw Exception( "[UndoHistory::push] Error: invalid move" );
+
+    if( this->canRedo() )
+    {
+        if( m_Branching )
+            this->branchOff();
+        else
+            this->truncate();
+    }
+
+    write( m_Words, m_Position, code );
+    ++m_Position;
+    m_Size = m_Position;
+}
+
+// --------------------------------------------------------------
+char UndoHistory::undo( void )
+{
+    --m_Position;
+    return decode( read( m_Words, m_Position ) );
+}
+
+// --------------------------------------------------------------
+char UndoHistory::redo( void )
+{
+    return decode( read( m_Words, m_Position++ ) );
+}
+
+// --------------------------------------------------------------
+bool UndoHistory::canUndo( void ) const
+{
+    return m_Position != 0;
+}
+
+// --------------------------------------------------------------
+bool UndoHistory::canRedo( void ) const
+{
+    return m_Position < m_Size;
+}
+
+// --------------------------------------------------------------
+void UndoHistory::truncate( void )
+{
+
+    // stale bits past the end are overwritten by the next push, so cutting
+    // the moves off only means moving the end
+    m_Size = m_Position;
+    if( m_Branches.empty() ) return;
+
+    // branches leaving from the discarded moves go with them
+    std::vector<bool> erase( m_Branches.size(), false );
+    for( std::size_t i = 0; i != m_Branches.size(); ++i )
+        if( m_Branches[i].owner == NO_BRANCH && m_Branches[i].depth > m_Position )
+            erase[i] = true;
+    this->eraseBranches( erase );
+}
+
+// --------------------------------------------------------------
+char UndoHistory::at( const std::size_t& index ) const
+{
+    return decode( read( m_Words, index ) );
+}
+
+// --------------------------------------------------------------
+std::size_t UndoHistory::getPosition( void ) const
+{
+    return m_Position;
+}
+
+// --------------------------------------------------------------
+std::size_t UndoHistory::size( void ) const
+{
+    return m_Size;
+}
+
+// --------------------------------------------------------------
+std::string UndoHistory::toString( void ) const
+{
+    std::string moves( m_Size, ' ' );
+    for( std::size_t i = 0; i != m_Size; ++i )
+        moves[i] = decode( read( m_Words, i ) );
+    return moves;
+}
+
+// --------------------------------------------------------------
+void UndoHistory::setBranching( const bool& enable )
+{
+    m_Branching = enable;
+}
+
+// --------------------------------------------------------------
+bool UndoHistory::getBranching( void ) const
+{
+    return m_Branching;
+}
+
+// --------------------------------------------------------------
+std::size_t UndoHistory::getNumBranches( void ) const
+{
+    std::size_t count = 0;
+    for( std::vector<Branch>::const_iterator it = m_Branches.begin(); it != m_Branches.end(); ++it )
+        if( it->owner == NO_BRANCH && it->depth == m_Position )
+            ++count;
+    return count;
+}
+
+// --------------------------------------------------------------
+void UndoHistory::selectBranch( const std::size_t& index )
+{
+
+    // find the branch
+    std::size_t selected = NO_BRANCH, count = 0;
+    for( std::size_t i = 0; i != m_Branches.size(); ++i )
+    {
+        if( m_Branches[i].owner != NO_BRANCH || m_Branches[i].depth != m_Position ) continue;
+        if( count++ == index ) { selected = i; break; }
+    }
+    if( selected == NO_BRANCH )
+        throw Exception( "[UndoHistory::selectBranch] Error: index out of range" );
+    Branch& branch = m_Branches[selected];
+
+    // cut the redo moves off
+    std::vector<Uint64> tail( (m_Size - m_Position + MOVES_PER_WORD - 1) / MOVES_PER_WORD, 0 );
+    for( std::size_t i = m_Position; i != m_Size; ++i )
+        write( tail, i - m_Position, read( m_Words, i ) );
+    std::size_t tailSize = m_Size - m_Position;
+
+    // continue with the branch's moves
+    for( std::size_t i = 0; i != branch.size; ++i )
+        write( m_Words, m_Position + i, read( branch.words, i ) );
+    m_Size = m_Position + branch.size;
+
+    // branches leaving from either line switch places with it
+    for( std::size_t i = 0; i != m_Branches.size(); ++i )
+    {
+        if( m_Branches[i].owner == NO_BRANCH && m_Branches[i].depth > m_Position )
+            m_Branches[i].owner = selected;
+        else if( m_Branches[i].owner == selected )
+            m_Branches[i].owner = NO_BRANCH;
+    }
+
+    // the old redo moves take the branch's place
+    if( tailSize )
+    {
+        branch.words.swap( tail );
+        branch.size = tailSize;
+    }
+    else
+    {
+        std::vector<bool> erase( m_Branches.size(), false );
+        erase[selected] = true;
+        this->eraseBranches( erase );
+    }
+}
+
+// --------------------------------------------------------------
+void UndoHistory::branchOff( void )
+{
+    Branch branch;
+    branch.owner = NO_BRANCH;
+    branch.depth = m_Position;
+    branch.size = m_Size - m_Position;
+    branch.words.assign( (branch.size + MOVES_PER_WORD - 1) / MOVES_PER_WORD, 0 );
+    for( std::size_t i = 0; i != branch.size; ++i )
+        write( branch.words, i, read( m_Words, m_Position + i ) );
+
+    // branches leaving from the redo moves now leave from the new branch
+    for( std::vector<Branch>::iterator it = m_Branches.begin(); it != m_Branches.end(); ++it )
+        if( it->owner == NO_BRANCH && it->depth > m_Position )
+            it->owner = m_Branches.size();
+
+    m_Branches.push_back( branch );
+    m_Size = m_Position;
+}
+
+// --------------------------------------------------------------
+void UndoHistory::eraseBranches( std::vector<bool>& erase )
+{
+
+    // branches leaving from erased branches are erased as well
+    for( bool changed = true; changed; )
+    {
+        changed = false;
+        for( std::size_t i = 0; i != m_Branches.size(); ++i )
+        {
+            if( erase[i] || m_Branches[i].owner == NO_BRANCH || !erase[m_Branches[i].owner] ) continue;
+            erase[i] = true;
+            changed = true;
+        }
+    }
+
+    // compact and fix up owners
+    std::vector<std::size_t> newIndex( m_Branches.size(), NO_BRANCH );
+    std::size_t count = 0;
+    for( std::size_t i = 0; i != m_Branches.size(); ++i )
+    {
+        if( erase[i] ) continue;
+        newIndex[i] = count;
+        if( i != count ) m_Branches[count].words.swap( m_Branches[i].words );
+        m_Branches[count].owner = m_Branches[i].owner;
+        m_Branches[count].depth = m_Branches[i].depth;
+        m_Branches[count].size = m_Branches[i].size;
+        ++count;
+    }
+    m_Branches.resize( count );
+    for( std::vector<Branch>::iterator it = m_Branches.begin(); it != m_Branches.end(); ++it )
+        if( it->owner != NO_BRANCH )
+            it->owner = newIndex[it->owner];
+}
+
+// --------------------------------------------------------------
+Uint8 UndoHistory::encode( const char& move )
+{
+    for( Uint8 code = 0; code != 8; ++code )
+        if( MOVE_CHARS[code] == move )
+            return code;
+    return INVALID_MOVE;
+}
+
+// --------------------------------------------------------------
+char UndoHistory::decode( const Uint8& code )
+{
+    return MOVE_CHARS[code];
+}
+
+// --------------------------------------------------------------
+void UndoHistory::write( std::vector<Uint64>& words, const std::size_t& index, const Uint8& code )
+{
+    std::size_t word = index / MOVES_PER_WORD, shift = (index % MOVES_PER_WORD) * 3;
+    if( word >= words.size() )
+        words.resize( word + 1 + (word >> 1), 0 );
+    words[word] = ( words[word] & ~(Uint64(7) << shift) ) | ( Uint64(code) << shift );
+}
+
+// --------------------------------------------------------------
+Uint8 UndoHistory::read( const std::vector<Uint64>& words, const std::size_t& index )
+{
+    return static_cast<Uint8>( ( words[index / MOVES_PER_WORD] >> ((index % MOVES_PER_WORD) * 3) ) & 7 );
+}
+
+} // namespace Chocobun
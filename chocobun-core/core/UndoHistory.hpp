@@ -0,0 +1,224 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// UndoHistory.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_UNDO_HISTORY_HPP__
+#define __CHOCOBUN_CORE_UNDO_HISTORY_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef> // std::size_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Stores the moves of a level for undo and redo
+ *
+ * Every move is packed into 3 bits (2 for the direction, 1 for whether a
+ * box was pushed), so 21 moves fit into a 64-bit word. Moves are passed in
+ * and out as LURD characters.
+ *
+ * The history has a current position. Moves before it can be undone,
+ * moves after it can be redone. Adding a move at a position before the end
+ * discards the redo moves in constant time.
+ *
+ * If branching is enabled, discarded redo moves are kept as a branch
+ * instead, turning the history into an undo tree. Branches hang off the
+ * position they were discarded at and can be switched back to from there.
+ */
+class UndoHistory
+{
+public:
+
+    /*!
+     * @brief Constructor
+     */
+    UndoHistory( void );
+
+    /*!
+     * @brief Destructor
+     */
+    ~UndoHistory( void );
+
+    /*!
+     * @brief Exchanges the moves and branches of two histories without copying them
+     */
+    void swap( UndoHistory& that ) noexcept;
+
+    /*!
+     * @brief Erases all moves and branches
+     */
+    void clear( void );
+
+    /*!
+     * @brief Replaces the history with a sequence of moves
+     * Any existing branches are erased.
+     * @exception Chocobun::Exception if a move is invalid or the position
+     * is past the last move
+     * @param moves The moves as a LURD string
+     * @param position The number of moves which were already made
+     */
+    void assign( const std::string& moves, const std::size_t& position );
+
+    /*!
+     * @brief Adds a move at the current position and advances past it
+     * Redo moves are discarded, or kept as a branch if branching is enabled.
+     * @exception Chocobun::Exception if the move is invalid
+     * @param move One of u, d, l, r, or U, D, L, R for pushes
+     */
+    void push( const char& move );
+
+    /*!
+     * @brief Steps back by one move
+     * @note Only call this if @a canUndo returns true
+     * @return Returns the move that was stepped over
+     */
+    char undo( void );
+
+    /*!
+     * @brief Steps forward by one move
+     * @note Only call this if @a canRedo returns true
+     * @return Returns the move that was stepped over
+     */
+    char redo( void );
+
+    /*!
+     * @brief Checks if there are moves before the current position
+     */
+    bool canUndo( void ) const;
+
+    /*!
+     * @brief Checks if there are moves after the current position
+     */
+    bool canRedo( void ) const;
+
+    /*!
+     * @brief Discards all moves after the current position
+     * This ignores whether branching is enabled.
+     */
+    void truncate( void );
+
+    /*!
+     * @brief Gets a move
+     * @param index The index of the move. Must be lower than @a size.
+     */
+    char at( const std::size_t& index ) const;
+
+    /*!
+     * @brief Gets the number of moves before the current position
+     */
+    std::size_t getPosition( void ) const;
+
+    /*!
+     * @brief Gets the number of moves, including the ones that can be redone
+     */
+    std::size_t size( void ) const;
+
+    /*!
+     * @brief Gets all moves as a LURD string
+     */
+    std::string toString( void ) const;
+
+    /*!
+     * @brief Sets whether discarded redo moves are kept as branches
+     * @note Default is false
+     */
+    void setBranching( const bool& enable );
+
+    /*!
+     * @brief Gets whether discarded redo moves are kept as branches
+     */
+    bool getBranching( void ) const;
+
+    /*!
+     * @brief Gets the number of branches starting at the current position
+     */
+    std::size_t getNumBranches( void ) const;
+
+    /*!
+     * @brief Replaces the redo moves with a branch starting at the current position
+     * The replaced redo moves are kept as a branch in return.
+     * @exception Chocobun::Exception if the index is out of range
+     * @param index The branch to switch to, lower than @a getNumBranches
+     */
+    void selectBranch( const std::size_t& index );
+
+private:
+
+    /*!
+     * @brief Redo moves which were replaced by other moves
+     */
+    struct Branch
+    {
+        std::size_t         owner;  // branch this one leaves from, or NO_BRANCH for the current line
+        std::size_t         depth;  // number of moves from the start of the level to the branch
+        std::vector<Uint64> words;
+        std::size_t         size;
+    };
+
+    /*!
+     * @brief Moves the redo moves into a new branch, so they can be replaced
+     * Branches leaving from the redo moves are moved along with them.
+     */
+    void branchOff( void );
+
+    /*!
+     * @brief Erases the flagged branches and all branches leaving from them
+     * @param erase One flag per branch. Flags of the branches leaving from
+     * flagged ones are set as well.
+     */
+    void eraseBranches( std::vector<bool>& erase );
+
+    /*!
+     * @brief Converts a LURD character to its 3 bit code
+     * @return Returns a value greater than 7 if the character is invalid
+     */
+    static Uint8 encode( const char& move );
+
+    /*!
+     * @brief Converts a 3 bit code to its LURD character
+     */
+    static char decode( const Uint8& code );
+
+    /*!
+     * @brief Writes a 3 bit code into a packed array
+     */
+    static void write( std::vector<Uint64>& words, const std::size_t& index, const Uint8& code );
+
+    /*!
+     * @brief Reads a 3 bit code from a packed array
+     */
+    static Uint8 read( const std::vector<Uint64>& words, const std::size_t& index );
+
+    std::vector<Uint64>     m_Words;
+    std::size_t             m_Size;
+    std::size_t             m_Position;
+    bool                    m_Branching;
+    std::vector<Branch>     m_Branches;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_UNDO_HISTORY_HPP__
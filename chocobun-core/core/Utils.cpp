@@ -22,58 +22,162 @@
 #include <core/Config.hpp>
 #include <core/Utils.hpp>
 
+#if defined(CHOCOBUN_CORE_SIMD_SSE2)
+#   include <emmintrin.h>
+#endif
+#if defined(CHOCOBUN_CORE_SIMD_AVX2)
+#   include <immintrin.h>
+#endif
+
 namespace Chocobun {
 
-const std::string Utils::validTiles = "#@+$*. _pPbB";
-const std::string Utils::validTilesRLE = validTiles + "()0123456789|";
-const std::string Utils::validUndoData = "udlrUDLR";
+// --------------------------------------------------------------
+// Every character has a set of class bits:
+// TILE     "#@+$*. _pPbB"
+// TILE_RLE tiles and "()0123456789|"
+// UNDO     "udlrUDLR"
+const Uint8 Utils::charClass[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x10
+    3, 0, 0, 3, 3, 0, 0, 0, 2, 2, 3, 3, 0, 0, 3, 0, // 0x20
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, // 0x30
+    3, 0, 3, 0, 4, 0, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, // 0x40
+    3, 0, 4, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, // 0x50
+    0, 0, 3, 0, 4, 0, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, // 0x60
+    3, 0, 4, 0, 0, 4, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, // 0x70
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x80
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x90
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xA0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xB0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xC0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xD0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xE0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 // 0xF0
+};
 
 // --------------------------------------------------------------
 bool Utils::isTileData( const std::string& str )
 {
-    if( str.size() == 0 ) return false;
-    for( std::size_t i = 0; i != str.size(); ++i )
-        if( validTiles.find(str[i]) == std::string::npos )
-            return false;
-    return true;
+    return isTileLine( str.data(), str.size() );
+}
+
+// --------------------------------------------------------------
+bool Utils::isTileData( const StringView& str )
+{
+    return isTileLine( str.data(), str.size() );
 }
 
 // --------------------------------------------------------------
 bool Utils::isTileData( const char& chr )
 {
-    return (validTiles.find(chr) != std::string::npos);
+    return ( charClass[static_cast<Uint8>(chr)] & TILE ) != 0;
 }
 
-// --------------------------------------------------------------
-bool Utils::isTileDataRLE( const std::string& str )
+// --------------------------------------------------------------
+bool Utils::isTileDataRLE( const std::string& str )
 {
-    if( str.size() == 0 ) return false;
-    for( std::size_t i = 0; i != str.size(); ++i )
-        if( validTilesRLE.find(str[i]) == std::string::npos )
-            return false;
-    return true;
+    return isClass( str.data(), str.size(), TILE_RLE );
 }
 
 // --------------------------------------------------------------
 bool Utils::isTileDataRLE( const char& chr )
 {
-    return (validTilesRLE.find(chr) != std::string::npos);
+    return ( charClass[static_cast<Uint8>(chr)] & TILE_RLE ) != 0;
+}
+
+// --------------------------------------------------------------
+bool Utils::isTileLineRLE( const StringView& str )
+{
+    return str.find( '#' ) != std::string::npos && isClass( str.data(), str.size(), TILE_RLE );
 }
 
 // --------------------------------------------------------------
 bool Utils::isUndoData( const std::string& str )
 {
-    if( str.size() == 0 ) return false;
-    for( std::size_t i = 0; i != str.size(); ++i )
-        if( validUndoData.find(str[i]) == std::string::npos )
+    return isClass( str.data(), str.size(), UNDO );
+}
+
+// --------------------------------------------------------------
+bool Utils::isUndoData( const char& chr )
+{
+    return ( charClass[static_cast<Uint8>(chr)] & UNDO ) != 0;
+}
+
+// --------------------------------------------------------------
+const char* Utils::getInstructionSet( void )
+{
+#if defined(CHOCOBUN_CORE_SIMD_AVX2)
+    return "AVX2";
+#elif defined(CHOCOBUN_CORE_SIMD_SSE2)
+    return "SSE2";
+#else
+    return "none";
+#endif
+}
+
+// --------------------------------------------------------------
+bool Utils::isClass( const char* data, const std::size_t& size, const Uint8& mask )
+{
+    if( size == 0 ) return false;
+    for( std::size_t i = 0; i != size; ++i )
+        if( !(charClass[static_cast<Uint8>(data[i])] & mask) )
             return false;
     return true;
 }
 
 // --------------------------------------------------------------
-bool Utils::isUndoData( const char& chr )
+bool Utils::isTileLine( const char* data, const std::size_t& size )
 {
-    return (validUndoData.find(chr) != std::string::npos);
+    if( size == 0 ) return false;
+    std::size_t i = 0;
+
+    // compare whole blocks of characters against every valid tile at once
+    // and only look the remaining characters up in the table
+#if defined(CHOCOBUN_CORE_SIMD_AVX2)
+    if( size >= 32 )
+    {
+        const __m256i tiles[12] = {
+            _mm256_set1_epi8('#'), _mm256_set1_epi8('@'), _mm256_set1_epi8('+'),
+            _mm256_set1_epi8('$'), _mm256_set1_epi8('*'), _mm256_set1_epi8('.'),
+            _mm256_set1_epi8(' '), _mm256_set1_epi8('_'), _mm256_set1_epi8('p'),
+            _mm256_set1_epi8('P'), _mm256_set1_epi8('b'), _mm256_set1_epi8('B')
+        };
+        for( ; i + 32 <= size; i += 32 )
+        {
+            __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(data + i) );
+            __m256i match = _mm256_cmpeq_epi8( block, tiles[0] );
+            for( int t = 1; t != 12; ++t )
+                match = _mm256_or_si256( match, _mm256_cmpeq_epi8( block, tiles[t] ) );
+            if( _mm256_movemask_epi8( match ) != -1 )
+                return false;
+        }
+    }
+#endif
+#if defined(CHOCOBUN_CORE_SIMD_SSE2)
+    if( size - i >= 16 )
+    {
+        const __m128i tiles[12] = {
+            _mm_set1_epi8('#'), _mm_set1_epi8('@'), _mm_set1_epi8('+'),
+            _mm_set1_epi8('$'), _mm_set1_epi8('*'), _mm_set1_epi8('.'),
+            _mm_set1_epi8(' '), _mm_set1_epi8('_'), _mm_set1_epi8('p'),
+            _mm_set1_epi8('P'), _mm_set1_epi8('b'), _mm_set1_epi8('B')
+        };
+        for( ; i + 16 <= size; i += 16 )
+        {
+            __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>(data + i) );
+            __m128i match = _mm_cmpeq_epi8( block, tiles[0] );
+            for( int t = 1; t != 12; ++t )
+                match = _mm_or_si128( match, _mm_cmpeq_epi8( block, tiles[t] ) );
+            if( _mm_movemask_epi8( match ) != 0xFFFF )
+                return false;
+        }
+    }
+#endif
+
+    for( ; i != size; ++i )
+        if( !(charClass[static_cast<Uint8>(data[i])] & TILE) )
+            return false;
+    return true;
 }
 
 } // namespace Chocobun
@@ -22,6 +22,9 @@
 #ifndef __CHOCOBUN_CORE_UTILS_HPP__
 #define __CHOCOBUN_CORE_UTILS_HPP__
 
+#include <core/Config.hpp>
+#include <core/StringView.hpp>
+
 #include <string>
 
 namespace Chocobun {
@@ -35,6 +38,11 @@ public:
      */
     static bool isTileData( const std::string& str );
 
+    /*!
+     * @brief
+     */
+    static bool isTileData( const StringView& str );
+
     /*!
      * @brief
      */
@@ -50,6 +58,14 @@ public:
      */
     static bool isTileDataRLE( const char& chr );
 
+    /*!
+     * @brief Checks if a line of a file is compressed tile data
+     * Unlike @a isTileDataRLE, the line also has to contain a wall. Lines
+     * made up of numbers and parentheses only can't be told apart from level
+     * titles, and every level has a wall somewhere.
+     */
+    static bool isTileLineRLE( const StringView& str );
+
     /*!
      * @brief
      */
@@ -60,10 +76,37 @@ public:
      */
     static bool isUndoData( const char& chr );
 
+    /*!
+     * @brief Gets the name of the instruction set used to validate lines of
+     * tile data, or "none" if lines are validated one character at a time
+     */
+    static const char* getInstructionSet( void );
+
 private:
-    static const std::string validTiles;
-    static const std::string validTilesRLE;
-    static const std::string validUndoData;
+
+    /*!
+     * @brief Class bits of the character class table
+     */
+    enum
+    {
+        TILE = 1,
+        TILE_RLE = 2,
+        UNDO = 4
+    };
+
+    /*!
+     * @brief Checks if all characters have one of the class bits set
+     * @return False for empty strings
+     */
+    static bool isClass( const char* data, const std::size_t& size, const Uint8& mask );
+
+    /*!
+     * @brief Checks if all characters are tiles, using SIMD if available
+     * @return False for empty strings
+     */
+    static bool isTileLine( const char* data, const std::size_t& size );
+
+    static const Uint8 charClass[256];
 };
 
 } // namespace Chocobun
@@ -0,0 +1,84 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// WorkStealingQueue.cpp
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/WorkStealingQueue.hpp>
+
+namespace Chocobun {
+
+// --------------------------------------------------------------
+WorkStealingQueue::WorkStealingQueue( void ) :
+    m_Top( 0 ),
+    m_Bottom( 0 )
+{
+}
+
+// --------------------------------------------------------------
+WorkStealingQueue::~WorkStealingQueue( void )
+{
+}
+
+// --------------------------------------------------------------
+void WorkStealingQueue::assign( const Uint32* items, const std::size_t& count )
+{
+    m_Items.assign( items, items + count );
+    m_Top.store( 0 );
+    m_Bottom.store( static_cast<std::ptrdiff_t>( count ) );
+}
+
+// --------------------------------------------------------------
+bool WorkStealingQueue::pop( Uint32& item )
+{
+
+    // reserve the bottom item before checking for thieves
+    std::ptrdiff_t bottom = m_Bottom.load( std::memory_order_relaxed ) - 1;
+    m_Bottom.store( bottom );
+    std::ptrdiff_t top = m_Top.load();
+    if( top > bottom )
+    {
+        m_Bottom.store( bottom+1, std::memory_order_relaxed );
+        return false;
+    }
+    item = m_Items[bottom];
+    if( top != bottom ) return true;
+
+    // last item, race against thieves for it
+    bool won = m_Top.compare_exchange_strong( top, top+1 );
+    m_Bottom.store( bottom+1, std::memory_order_relaxed );
+    return won;
+}
+
+// --------------------------------------------------------------
+bool WorkStealingQueue::steal( Uint32& item )
+{
+    for(;;)
+    {
+        std::ptrdiff_t top = m_Top.load();
+        std::ptrdiff_t bottom = m_Bottom.load();
+        if( top >= bottom ) return false;
+        item = m_Items[top];
+        if( m_Top.compare_exchange_strong( top, top+1 ) ) return true;
+    }
+}
+
+} // namespace Chocobun
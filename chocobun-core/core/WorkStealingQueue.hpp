@@ -0,0 +1,93 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// WorkStealingQueue.hpp
+// --------------------------------------------------------------
+
+#ifndef __CHOCOBUN_CORE_WORK_STEALING_QUEUE_HPP__
+#define __CHOCOBUN_CORE_WORK_STEALING_QUEUE_HPP__
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Config.hpp>
+
+#include <vector>
+#include <atomic>
+#include <cstddef> // std::ptrdiff_t
+
+namespace Chocobun {
+
+/*!
+ * @brief Lock-free double ended queue of work items (Chase-Lev)
+ *
+ * Each worker thread owns one queue and takes items from its bottom end.
+ * When a worker runs out of items, it steals from the top end of the
+ * queues owned by other workers.
+ *
+ * The queue is filled with @a assign before any worker starts. Only
+ * @a pop and @a steal may be called concurrently.
+ */
+class WorkStealingQueue
+{
+public:
+
+    /*!
+     * @brief Constructor
+     */
+    WorkStealingQueue( void );
+
+    /*!
+     * @brief Destructor
+     */
+    ~WorkStealingQueue( void );
+
+    /*!
+     * @brief Replaces the content of the queue
+     * @note This is not thread safe
+     * @param items Pointer to the first item to copy
+     * @param count The number of items to copy
+     */
+    void assign( const Uint32* items, const std::size_t& count );
+
+    /*!
+     * @brief Takes an item from the bottom of the queue
+     * @note May only be called by the thread owning the queue
+     * @param item Output for the item
+     * @return Returns false if the queue is empty
+     */
+    bool pop( Uint32& item );
+
+    /*!
+     * @brief Takes an item from the top of the queue
+     * @note May be called by any thread
+     * @param item Output for the item
+     * @return Returns false if the queue is empty
+     */
+    bool steal( Uint32& item );
+
+private:
+
+    std::vector<Uint32>         m_Items;
+    std::atomic<std::ptrdiff_t> m_Top;
+    std::atomic<std::ptrdiff_t> m_Bottom;
+};
+
+} // namespace Chocobun
+
+#endif // __CHOCOBUN_CORE_WORK_STEALING_QUEUE_HPP__
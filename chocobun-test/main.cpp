@@ -0,0 +1,192 @@
+/*
+ * This file is part of Chocobun.
+ *
+ * Chocobun is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Chocobun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Chocobun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------
+// Checks which are run outside of the console, so it can be shipped
+// without them. Returns non-zero if any of them fail.
+// --------------------------------------------------------------
+
+// --------------------------------------------------------------
+// include files
+
+#include <core/Collection.hpp>
+#include <core/CollectionParser.hpp>
+#include <core/Level.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Chocobun;
+
+// --------------------------------------------------------------
+// counts all heap allocations, so the allocations made by moving in a
+// level can be checked
+namespace {
+    std::atomic<std::size_t> numAllocations( 0 );
+}
+
+void* operator new( std::size_t size )
+{
+    ++numAllocations;
+    void* p = std::malloc( size ? size : 1 );
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+    std::free( p );
+}
+
+// --------------------------------------------------------------
+// everything of a level which has to survive saving and loading
+std::string describeLevel( Level& lvl )
+{
+    std::stringstream ss;
+    ss << lvl.getLevelName() << std::endl;
+    lvl.streamInitialTileData( ss );
+    ss << lvl.exportUndoData() << std::endl;
+    return ss.str();
+}
+
+// --------------------------------------------------------------
+// saves a collection with and without compression, loads it again and
+// compares the levels
+bool checkSaveLoad( const std::string& fileName )
+{
+    Collection original;
+    original.load( fileName );
+
+    std::vector<std::string> expected;
+    for( Collection::level_iterator it = original.level_begin(); it != original.level_end(); ++it )
+        expected.push_back( describeLevel( **it ) );
+
+    bool success = true;
+    for( int compress = 0; compress != 2; ++compress )
+    {
+
+        // the parser saves to the file name with an added "~"
+        std::string savedName = fileName + ".test";
+        CollectionParser parser;
+        parser.setFileFormat( "SOK" );
+        parser.save( savedName, original, compress != 0 );
+        savedName.append( "~" );
+
+        Collection saved;
+        saved.load( savedName );
+        std::size_t count = 0;
+        Collection::level_iterator it = saved.level_begin();
+        for( ; it != saved.level_end(); ++it, ++count )
+        {
+            if( count == expected.size() || describeLevel( **it ) != expected[count] )
+                break;
+        }
+        bool isEqual = ( it == saved.level_end() && count == expected.size() );
+        saved.unload();
+        std::remove( savedName.c_str() );
+
+        if( !isEqual )
+        {
+            std::cout << "FAILED: " << fileName << ( compress ? " (compressed)" : "" ) << " differs at level " << count+1 << " after saving and loading" << std::endl;
+            success = false;
+        }
+    }
+    original.unload();
+
+    if( success )
+        std::cout << "ok: " << fileName << " " << expected.size() << " levels saved and loaded" << std::endl;
+    return success;
+}
+
+// --------------------------------------------------------------
+// makes random moves in every level, starting over every thousand moves.
+// Apart from the first change to a board shared with the initial board,
+// moving must not allocate.
+bool checkMoves( const std::string& fileName )
+{
+    Collection collection;
+    collection.load( fileName );
+
+    std::size_t numMoves = 0;
+    std::size_t numPushes = 0;
+    std::size_t numMoveAllocations = 0;
+    Uint32 random = 1;
+    double elapsed = 0;
+    for( Collection::level_iterator it = collection.level_begin(); it != collection.level_end(); ++it )
+    {
+        Level& level = **it;
+        try {
+            level.validateLevel();
+        }catch( const std::exception& ) {
+            continue;
+        }
+
+        // the first round copies the board and isn't counted
+        for( int round = 0; round != 101; ++round )
+        {
+            level.reset();
+            std::size_t allocations = numAllocations;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for( int i = 0; i != 1000; ++i )
+            {
+                random = random * 1664525 + 1013904223;
+                if( level.step( "udlr"[random >> 30] ) >= Level::STEP_PUSHED ) ++numPushes;
+            }
+            if( !round ) continue;
+            elapsed += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            numMoveAllocations += numAllocations - allocations;
+            numMoves += 1000;
+        }
+    }
+    collection.unload();
+
+    std::cout << ( numMoveAllocations ? "FAILED: " : "ok: " ) << fileName << " " << numMoves << " moves (" << numPushes << " pushes) in " << elapsed << " seconds, ";
+    std::cout << numMoves / elapsed << " moves/sec, " << numMoveAllocations << " allocations" << std::endl;
+    return !numMoveAllocations;
+}
+
+// --------------------------------------------------------------
+// main entry point
+int main( int argc, char** argv )
+{
+
+    // collections to check are passed on the command line
+    std::vector<std::string> fileNames( argv+1, argv+argc );
+    if( fileNames.empty() )
+        fileNames.push_back( "collections/ksokoban-original.sok" );
+
+    bool success = true;
+    try {
+        for( std::vector<std::string>::iterator it = fileNames.begin(); it != fileNames.end(); ++it )
+        {
+            success = checkSaveLoad( *it ) && success;
+            success = checkMoves( *it ) && success;
+        }
+    }catch( const std::exception& e ) {
+        std::cout << "FAILED: exception caught: " << e.what() << std::endl;
+        success = false;
+    }
+
+    return ( success ? 0 : 1 );
+}
@@ -47,8 +47,10 @@ elseif os.get() == "linux" then
 
 	-- link libraries
 	linklibs_chocobun_core_debug = {
+		"pthread"
 	}
 	linklibs_chocobun_core_release = {
+		"pthread"
 	}
 	linklibs_chocobun_console_debug = {
 		"chocobun-core_d"
@@ -77,8 +79,10 @@ elseif os.get() == "macosx" then
 
 	-- link libraries
 	linklibs_chocobun_core_debug = {
+		"pthread"
 	}
 	linklibs_chocobun_core_release = {
+		"pthread"
 	}
 	linklibs_chocobun_console_debug = {
 		"chocobun-core_d"
@@ -117,6 +121,13 @@ solution "Chocobun"
 		"CHOCOBUN_CORE_DYNAMIC"
 	}
 	
+	-- the solver uses C++11 threads and atomics
+	if os.get() ~= "windows" then
+		buildoptions {
+			"-std=c++11"
+		}
+	end
+	
 	-------------------------------------------------------------------
 	-- Chocobun core
 	-------------------------------------------------------------------
@@ -201,3 +212,41 @@ solution "Chocobun"
 			}
 			libdirs (libSearchDirs)
 			links (linklibs_chocobun_console_release)
+
+	-------------------------------------------------------------------
+	-- Chocobun tests
+	-------------------------------------------------------------------
+	
+	-- checks which aren't part of the console, run from the repository root
+	project "chocobun-test"
+		kind "ConsoleApp"
+		language "C++"
+		files {
+			"chocobun-test/**.cpp",
+			"chocobun-test/**.hpp"
+		}
+		
+		includedirs (headerSearchDirs)
+		
+		configuration "Debug"
+			targetdir "bin/debug"
+			defines {
+				"DEBUG",
+				"_DEBUG"
+			}
+			flags {
+				"Symbols"
+			}
+			libdirs (libSearchDirs)
+			links (linklibs_chocobun_console_debug)
+			
+		configuration "Release"
+			targetdir "bin/release"
+			defines {
+				"NDEBUG"
+			}
+			flags {
+				"Optimize"
+			}
+			libdirs (libSearchDirs)
+			links (linklibs_chocobun_console_release)